@@ -0,0 +1,310 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace cycfi::elements;
+
+///////////////////////////////////////////////////////////////////////////////
+// Micro benchmarks for limits, layout, draw and hit testing, on synthetic
+// element trees drawn into an offscreen (headless) view.
+//
+// Usage: elements_bench [filter]
+//
+// Only the trees whose name contains filter are run.
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+   constexpr extent view_size = { 1024, 768 };
+   constexpr auto min_run_time = std::chrono::milliseconds{ 200 };
+
+   auto constexpr box_color = rgba(80, 80, 90, 255);
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Timing
+   ////////////////////////////////////////////////////////////////////////////
+
+   // Run f repeatedly for at least min_run_time and return the average
+   // time per run in nanoseconds. drain is called after each batch of
+   // runs, outside of the timed region (e.g. to run the tasks f posted).
+   template <typename F, typename D>
+   double time_ns(F&& f, std::size_t& runs, D&& drain)
+   {
+      using clock = std::chrono::steady_clock;
+      f(); // warm up
+      drain();
+
+      runs = 0;
+      auto elapsed = clock::duration{};
+      std::size_t batch = 1;
+      while (elapsed < min_run_time)
+      {
+         auto start = clock::now();
+         for (std::size_t i = 0; i != batch; ++i)
+            f();
+         elapsed += clock::now() - start;
+         runs += batch;
+         batch *= 2;
+         drain();
+      }
+      return std::chrono::duration<double, std::nano>(elapsed).count() / runs;
+   }
+
+   void report(std::string const& tree, char const* op, double ns, std::size_t runs)
+   {
+      std::printf("%-32s %-16s %16.1f ns %12zu runs\n", tree.c_str(), op, ns, runs);
+   }
+
+   // Deterministic pseudo random numbers (LCG) for hit test points
+   struct random_points
+   {
+      point next()
+      {
+         state = state * 6364136223846793005ull + 1442695040888963407ull;
+         auto x = float((state >> 33) % std::uint64_t(view_size.width));
+         state = state * 6364136223846793005ull + 1442695040888963407ull;
+         auto y = float((state >> 33) % std::uint64_t(view_size.height));
+         return { x, y };
+      }
+
+      std::uint64_t state = 42;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Benchmark a tree
+   ////////////////////////////////////////////////////////////////////////////
+   // The scheduler is drained after each batch of runs, outside of the
+   // timed region, so that the work the operations post does not pile up.
+   // The drain itself is timed separately ("poll").
+   void run(view& view_, std::string const& name, element_ptr root)
+   {
+      auto cr = cairo_create(view_.offscreen_surface());
+      canvas cnv{ *cr };
+      rect bounds = { 0, 0, view_size.width, view_size.height };
+      context ctx{ view_, cnv, root.get(), bounds };
+      std::size_t runs;
+      auto drain = [&] { view_.poll(); };
+
+      // limits with all cached limits invalidated
+      auto limits_ns = time_ns(
+         [&]
+         {
+            view_.invalidate_all_limits();
+            root->limits(ctx);
+         }, runs, drain
+      );
+      report(name, "limits", limits_ns, runs);
+
+      // full layout, with all cached limits and layouts invalidated
+      auto layout_ns = time_ns(
+         [&]
+         {
+            view_.invalidate_all_limits();
+            root->layout(ctx);
+         }, runs, drain
+      );
+      report(name, "layout", layout_ns, runs);
+
+      // relayout with nothing invalidated
+      auto update_ns = time_ns(
+         [&]
+         {
+            root->update_layout(ctx);
+         }, runs, drain
+      );
+      report(name, "layout (clean)", update_ns, runs);
+
+      auto draw_ns = time_ns(
+         [&]
+         {
+            root->draw(ctx);
+         }, runs, drain
+      );
+      report(name, "draw", draw_ns, runs);
+
+      random_points points;
+      auto hit_test_ns = time_ns(
+         [&]
+         {
+            root->hit_test(ctx, points.next());
+         }, runs, drain
+      );
+      report(name, "hit_test", hit_test_ns, runs);
+
+      // a refresh, up to the view's paint request (the paint itself is
+      // not included)
+      auto refresh_ns = time_ns(
+         [&]
+         {
+            view_.refresh(bounds);
+         }, runs, drain
+      );
+      report(name, "refresh", refresh_ns, runs);
+
+      // draining the scheduler (one main loop wakeup)
+      auto poll_ns = time_ns(drain, runs, [] {});
+      report(name, "poll", poll_ns, runs);
+
+      cairo_destroy(cr);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Synthetic trees
+   ////////////////////////////////////////////////////////////////////////////
+   element_ptr make_box()
+   {
+      return share(box(box_color));
+   }
+
+   // Nested vtiles and htiles, alternating per level, with the given
+   // number of children per tile
+   element_ptr make_tile_nest(int depth, std::size_t children, bool vertical = true)
+   {
+      if (depth == 0)
+         return make_box();
+
+      if (vertical)
+      {
+         auto c = share(vtile_composite{});
+         for (std::size_t i = 0; i != children; ++i)
+            c->push_back(make_tile_nest(depth-1, children, !vertical));
+         return c;
+      }
+
+      auto c = share(htile_composite{});
+      for (std::size_t i = 0; i != children; ++i)
+         c->push_back(make_tile_nest(depth-1, children, !vertical));
+      return c;
+   }
+
+   // A single tile with n children, exercising the space allocation in
+   // the tile's layout with large n
+   element_ptr make_wide_tile(std::size_t n)
+   {
+      auto c = share(htile_composite{});
+      for (std::size_t i = 0; i != n; ++i)
+      {
+         if (i % 3)
+            c->push_back(make_box());
+         else
+            c->push_back(share(hstretch(i % 7, hsize(float(i % 5 + 1), box(box_color)))));
+      }
+      return c;
+   }
+
+   // A panel (draw_panel, with its blurred drop shadow), with a margin
+   // for the shadow
+   element_ptr make_panel()
+   {
+      return share(margin({ 8, 8, 8, 8 }, panel{}));
+   }
+
+   // rows x columns grid of cells (vgrid of hgrids)
+   using equal_vgrid_composite = vector_composite<equal_grid<vgrid_element>>;
+   using equal_hgrid_composite = vector_composite<equal_grid<hgrid_element>>;
+
+   element_ptr make_grid(
+      std::size_t rows, std::size_t columns
+    , element_ptr (*make_cell)() = make_box
+   )
+   {
+      auto grid = share(equal_vgrid_composite{});
+      for (std::size_t r = 0; r != rows; ++r)
+      {
+         auto row = share(equal_hgrid_composite{});
+         for (std::size_t c = 0; c != columns; ++c)
+            row->push_back(make_cell());
+         grid->push_back(row);
+      }
+      return grid;
+   }
+
+   // A layer stack of n overlapping floating boxes
+   element_ptr make_layer_stack(std::size_t n)
+   {
+      auto layers = share(layer_composite{});
+      random_points points;
+      for (std::size_t i = 0; i != n; ++i)
+      {
+         auto p = points.next();
+         layers->push_back(share(floating({ p.x, p.y, p.x+40, p.y+30 }, box(box_color))));
+      }
+      return layers;
+   }
+
+   // A flow of n fixed size items
+   struct flow_tree
+   {
+      flow_composite items;
+      element_ptr root;
+   };
+
+   std::shared_ptr<flow_tree> make_flow(std::size_t n)
+   {
+      auto tree = std::make_shared<flow_tree>();
+      for (std::size_t i = 0; i != n; ++i)
+         tree->items.push_back(share(fixed_size({ float(10 + i % 30), 20 }, box(box_color))));
+      tree->root = share(flow(tree->items));
+      return tree;
+   }
+
+   // A dynamic_list with n rows
+   element_ptr make_dynamic_list(std::size_t n)
+   {
+      auto composer = basic_cell_composer(
+         100, 20, n,
+         [](std::size_t /* index */)
+         {
+            return make_box();
+         }
+      );
+      return share(dynamic_list{ composer });
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   std::string filter = (argc > 1)? argv[1] : "";
+   auto selected = [&](std::string const& name)
+   {
+      return filter.empty() || name.find(filter) != std::string::npos;
+   };
+
+   view view_(view_size);
+   view_.manual_clock(true);
+
+   std::printf("%-32s %-16s %19s %17s\n", "tree", "operation", "time per op", "");
+
+   if (selected("tile nest (depth 12, 2 wide)"))
+      run(view_, "tile nest (depth 12, 2 wide)", make_tile_nest(12, 2));
+   if (selected("tile nest (depth 4, 8 wide)"))
+      run(view_, "tile nest (depth 4, 8 wide)", make_tile_nest(4, 8));
+   if (selected("htile allocate (10000)"))
+      run(view_, "htile allocate (10000)", make_wide_tile(10000));
+   if (selected("htile allocate (100000)"))
+      run(view_, "htile allocate (100000)", make_wide_tile(100000));
+   if (selected("grid (50 x 40)"))
+      run(view_, "grid (50 x 40)", make_grid(50, 40));
+   if (selected("grid (10 x 500)"))
+      run(view_, "grid (10 x 500)", make_grid(10, 500));
+   if (selected("panels (20 x 15)"))
+      run(view_, "panels (20 x 15)", make_grid(20, 15, make_panel));
+   if (selected("layer stack (2000)"))
+      run(view_, "layer stack (2000)", make_layer_stack(2000));
+   if (selected("flow (5000)"))
+   {
+      auto tree = make_flow(5000);
+      run(view_, "flow (5000)", tree->root);
+   }
+   if (selected("dynamic_list (1000000)"))
+      run(view_, "dynamic_list (1000000)", make_dynamic_list(1000000));
+
+   return 0;
+}
@@ -8,20 +8,7 @@
 using namespace cycfi::elements;
 using namespace std::chrono_literals;
 
-float position = 0.0;
-constexpr float incr = 0.001;
-constexpr auto fps = 1000ms / 60;
-
-void animate(view& view_, vport_element& port)
-{
-   position += incr;
-   if (position < 1.0)
-      view_.post(fps, [&]() { animate(view_, port); });
-   else
-      position = 1.0;
-   port.valign(position);
-   view_.refresh();
-}
+constexpr auto animation_duration = 16s;
 
 int main(int argc, char* argv[])
 {
@@ -34,7 +21,14 @@ int main(int argc, char* argv[])
    auto port = share(vport(image{ "moving.png" }));
    view_.content(port);
 
-   view_.post(fps, [&]() { animate(view_, *port); });
+   // Scroll the image from top to bottom
+   view_.animator().play(
+      make_tween(
+         0.0f, 1.0f, animation_duration
+       , [&](float v) { port->valign(v); }
+       , port.get(), easing::linear
+      )
+   );
 
    _app.run();
    return 0;
@@ -7,24 +7,38 @@
 #include <cairo.h>
 #include <infra/assert.hpp>
 #include <elements/base_view.hpp>
+#include <elements/scheduler.hpp>
 #include <elements/window.hpp>
 #include <elements/support/canvas.hpp>
+#include <elements/support/region.hpp>
 #include <elements/support/resource_paths.hpp>
 #include <elements/support/text_utils.hpp>
 #include <gtk/gtk.h>
+#include <atomic>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace cycfi { namespace elements
 {
    struct host_view
    {
       host_view();
+      explicit host_view(extent offscreen_size_);
       ~host_view();
 
+      // The backing store. Only the dirty (damaged) region is redrawn
+      // into the surface; the window is painted from the surface.
       cairo_surface_t* surface = nullptr;
+      extent surface_size;
+      extent size;
+      region dirty;
       GtkWidget* widget = nullptr;
 
+      // Offscreen views
+      bool offscreen = false;
+      extent offscreen_size;
+
       // Mouse button click tracking
       std::uint32_t click_time = 0;
       std::uint32_t click_count = 0;
@@ -34,6 +48,11 @@ namespace cycfi { namespace elements
 
       point cursor_position;
 
+      // Coalesced motion (see on_motion)
+      bool motion_pending = false;
+      mouse_button motion;
+      std::vector<point> motion_history;
+
       using key_map = std::map<key_code, key_action>;
       key_map keys;
 
@@ -42,6 +61,10 @@ namespace cycfi { namespace elements
       GtkIMContext* im_context;
 
       GdkCursorType active_cursor_type = GDK_ARROW;
+
+      // The widget's frame clock, once a frame is requested
+      GdkFrameClock* frame_clock = nullptr;
+      gulong frame_handler = 0;
    };
 
    struct platform_access
@@ -57,8 +80,23 @@ namespace cycfi { namespace elements
    {
    }
 
+   host_view::host_view(extent offscreen_size_)
+    : offscreen(true)
+    , offscreen_size(offscreen_size_)
+    , im_context(nullptr)
+   {
+      surface = cairo_image_surface_create(
+         CAIRO_FORMAT_ARGB32, offscreen_size.width, offscreen_size.height
+      );
+   }
+
    host_view::~host_view()
    {
+      if (frame_clock)
+      {
+         g_signal_handler_disconnect(frame_clock, frame_handler);
+         g_object_unref(frame_clock);
+      }
       if (surface)
          cairo_surface_destroy(surface);
       surface = nullptr;
@@ -75,38 +113,102 @@ namespace cycfi { namespace elements
          return *reinterpret_cast<base_view*>(user_data);
       }
 
+      // The backing store grows in steps of this many pixels, and never
+      // shrinks, so that a live resize does not reallocate it on every
+      // configure
+      constexpr int surface_size_step = 256;
+
+      int grow_surface_size(int size, float current)
+      {
+         auto stepped = ((size + surface_size_step - 1) / surface_size_step) * surface_size_step;
+         return std::max(stepped, int(current));
+      }
+
       gboolean on_configure(GtkWidget* widget, GdkEventConfigure* /* event */, gpointer user_data)
       {
          auto& view = get(user_data);
          auto* host_view_h = platform_access::get_host_view(view);
 
-         if (host_view_h->surface)
-            cairo_surface_destroy(host_view_h->surface);
+         auto width = gtk_widget_get_allocated_width(widget);
+         auto height = gtk_widget_get_allocated_height(widget);
+         extent size = { float(width), float(height) };
+         auto const& prev = host_view_h->size;
+         if (host_view_h->surface && size.width == prev.width && size.height == prev.height)
+            return true; // moved, not resized
 
-         host_view_h->surface = gdk_window_create_similar_surface(
-            gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR,
-            gtk_widget_get_allocated_width(widget),
-            gtk_widget_get_allocated_height(widget)
-         );
+         auto& surface_size = host_view_h->surface_size;
+         if (!host_view_h->surface
+            || width > surface_size.width || height > surface_size.height)
+         {
+            if (host_view_h->surface)
+               cairo_surface_destroy(host_view_h->surface);
+
+            surface_size = {
+               float(grow_surface_size(width, surface_size.width))
+             , float(grow_surface_size(height, surface_size.height))
+            };
+            host_view_h->surface = gdk_window_create_similar_surface(
+               gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR,
+               surface_size.width, surface_size.height
+            );
+         }
+
+         // The layout changes with the size: redraw everything
+         host_view_h->size = size;
+         host_view_h->dirty.clear();
+         host_view_h->dirty.add({ 0, 0, size.width, size.height });
          return true;
       }
 
+      // Redraw the dirty region of the view into its backing store. The
+      // view gets the region from the clip.
+      void draw_dirty(base_view& view, host_view* host_view_h)
+      {
+         auto& dirty = host_view_h->dirty;
+         rect area = dirty.bounds();
+
+         auto cr = cairo_create(host_view_h->surface);
+         for (auto const& r : dirty.rects())
+            cairo_rectangle(cr, r.left, r.top, r.width(), r.height());
+         cairo_clip(cr);
+         dirty.clear();
+         if (host_view_h->offscreen || !host_view_h->widget)
+         {
+            // Offscreen surfaces have an alpha channel: clear to transparent
+            cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+            cairo_paint(cr);
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+         }
+         else
+         {
+            // The backing store has no alpha channel: clear to the window's
+            // background, as GTK does before drawing the widget
+            auto* window = gtk_widget_get_toplevel(host_view_h->widget);
+            gtk_render_background(
+               gtk_widget_get_style_context(window), cr
+             , 0, 0, host_view_h->size.width, host_view_h->size.height
+            );
+         }
+         view.draw(cr, area);
+         cairo_destroy(cr);
+      }
+
       gboolean on_draw(GtkWidget* /* widget */, cairo_t* cr, gpointer user_data)
       {
          auto& view = get(user_data);
          auto* host_view_h = platform_access::get_host_view(view);
-         cairo_set_source_surface(cr, host_view_h->surface, 0, 0);
-         cairo_paint(cr);
+         if (!host_view_h->surface)
+            return false;
 
-         // Note that cr (cairo_t) is already clipped to only draw the
-         // exposed areas of the widget.
-         double left, top, right, bottom;
-         cairo_clip_extents(cr, &left, &top, &right, &bottom);
-         view.draw(
-            cr,
-            rect{ float(left), float(top), float(right), float(bottom) }
-         );
+         // Only the damaged area is drawn. Exposes (e.g. from overlapping
+         // windows) are painted from the backing store. Note that cr
+         // (cairo_t) is already clipped to only paint the exposed areas of
+         // the widget.
+         if (!host_view_h->dirty.empty())
+            draw_dirty(view, host_view_h);
 
+         cairo_set_source_surface(cr, host_view_h->surface, 0, 0);
+         cairo_paint(cr);
          return false;
       }
 
@@ -166,15 +268,46 @@ namespace cycfi { namespace elements
          return true;
       }
 
-      gboolean on_button(GtkWidget* /* widget */, GdkEventButton* event, gpointer user_data)
+      // The maximum number of positions kept in the motion history
+      constexpr std::size_t max_motion_history = 64;
+
+      // Dispatch the pending (coalesced) motion, if any
+      void dispatch_motion(base_view& base_view)
+      {
+         auto* view = platform_access::get_host_view(base_view);
+         if (!view->motion_pending)
+            return;
+         view->motion_pending = false;
+
+         auto btn = view->motion;
+         if (btn.down)
+            base_view.drag(btn);
+         else
+            base_view.cursor(btn.pos, cursor_tracking::hovering);
+         view->motion_history.clear();
+      }
+
+      gboolean on_button(GtkWidget* widget, GdkEventButton* event, gpointer user_data)
       {
          auto& view = get(user_data);
+         dispatch_motion(view);
+
          mouse_button btn;
          if (get_button(event, btn, platform_access::get_host_view(view)))
+         {
+            // While dragging, turn off GDK's motion compression, so that
+            // the motion history gets all the positions
+            gdk_window_set_event_compression(gtk_widget_get_window(widget), !btn.down);
             view.click(btn);
+         }
          return true;
       }
 
+      // Motion events are coalesced: only the latest is dispatched, once
+      // per frame (see on_frame_update), with the positions since the last
+      // dispatch kept in the motion history (see base_view::motion_history).
+      // Pending motion is dispatched before button, scroll and crossing
+      // events, to keep them in order.
       gboolean on_motion(GtkWidget* /* widget */, GdkEventMotion* event, gpointer user_data)
       {
          auto& base_view = get(user_data);
@@ -204,10 +337,21 @@ namespace cycfi { namespace elements
                btn.down = false;
             }
 
+            auto& history = view->motion_history;
+            if (!btn.down)
+               history.clear();
+            else if (history.size() == max_motion_history)
+               history.erase(history.begin());
             if (btn.down)
-               base_view.drag(btn);
-            else
-               base_view.cursor(view->cursor_position, cursor_tracking::hovering);
+               history.push_back(btn.pos);
+
+            view->motion = btn;
+            if (!view->motion_pending)
+            {
+               view->motion_pending = true;
+               if (!base_view.request_frame())
+                  dispatch_motion(base_view);
+            }
          }
          return true;
       }
@@ -215,6 +359,7 @@ namespace cycfi { namespace elements
       gboolean on_scroll(GtkWidget* /* widget */, GdkEventScroll* event, gpointer user_data)
       {
          auto& base_view = get(user_data);
+         dispatch_motion(base_view);
          auto* host_view_h = platform_access::get_host_view(base_view);
          auto elapsed = std::max<float>(10.0f, event->time - host_view_h->scroll_time);
          static constexpr float _1s = 100;
@@ -266,6 +411,7 @@ namespace cycfi { namespace elements
    gboolean on_event_crossing(GtkWidget* widget, GdkEventCrossing* event, gpointer user_data)
    {
       auto& base_view = get(user_data);
+      dispatch_motion(base_view);
       auto* host_view_h = platform_access::get_host_view(base_view);
       host_view_h->cursor_position = point{ float(event->x), float(event->y) };
       if (event->type == GDK_ENTER_NOTIFY)
@@ -372,11 +518,90 @@ namespace cycfi { namespace elements
          base_view.end_focus();
    }
 
-   int poll_function(gpointer user_data)
+   // The app scheduler is polled through a GSource that becomes ready
+   // only when asked to wake up (see wake_main_loop), instead of waking
+   // the main loop on a fixed interval. Immediate wakeups set the pending
+   // flag, checked by the source, and wake the main context, without
+   // locking. Timed wakeups set the source's ready time, which is rearmed
+   // for the scheduler's next wake time after each poll.
+   namespace
    {
-      auto& base_view = get(user_data);
-      base_view.poll();
-      return true;
+      using wake_time = scheduler::clock_type::time_point;
+
+      struct main_loop_wakeup
+      {
+         GSource* source;
+         std::atomic<bool> pending{ false };
+         wake_time deadline = wake_time::max();
+      };
+
+      // Set the source's ready time (monotonic, in microseconds) to t
+      void set_ready_time(GSource* source, wake_time t)
+      {
+         using std::chrono::microseconds;
+         auto delay = std::chrono::ceil<microseconds>(t - scheduler::clock_type::now()).count();
+         g_source_set_ready_time(source, g_get_monotonic_time() + std::max<gint64>(delay, 0));
+      }
+
+      main_loop_wakeup& get_wakeup();
+
+      gboolean wakeup_prepare(GSource* /* source */, gint* timeout)
+      {
+         *timeout = -1;
+         return get_wakeup().pending.load();
+      }
+
+      gboolean wakeup_check(GSource* /* source */)
+      {
+         return get_wakeup().pending.load();
+      }
+
+      gboolean wakeup_dispatch(GSource* source, GSourceFunc /* callback */, gpointer /* user_data */)
+      {
+         auto& wakeup = get_wakeup();
+         wakeup.pending = false;
+         app_scheduler().poll();
+
+         // Rearm for the scheduler's next wake time. Cancelled timers are
+         // no longer pending, so they do not wake us up.
+         wakeup.deadline = app_scheduler().next_wake();
+         if (wakeup.deadline == wake_time::max())
+            g_source_set_ready_time(source, -1);
+         else
+            set_ready_time(source, wakeup.deadline);
+         return G_SOURCE_CONTINUE;
+      }
+
+      GSourceFuncs wakeup_funcs = { wakeup_prepare, wakeup_check, wakeup_dispatch, nullptr, nullptr, nullptr };
+
+      main_loop_wakeup& get_wakeup()
+      {
+         static main_loop_wakeup wakeup = []
+         {
+            auto* source = g_source_new(&wakeup_funcs, sizeof(GSource));
+            g_source_set_ready_time(source, -1);
+            g_source_attach(source, nullptr);
+            return main_loop_wakeup{ source };
+         }();
+         return wakeup;
+      }
+   }
+
+   void wake_main_loop()
+   {
+      // Called from any thread. g_main_context_wakeup does not lock.
+      get_wakeup().pending = true;
+      g_main_context_wakeup(nullptr);
+   }
+
+   void wake_main_loop(wake_time t)
+   {
+      auto& wakeup = get_wakeup();
+      if (t < wakeup.deadline)
+      {
+         wakeup.deadline = t;
+         set_ready_time(wakeup.source, t);
+      }
    }
 
    GtkWidget* make_view(base_view& view, GtkWidget* parent)
@@ -434,9 +659,6 @@ namespace cycfi { namespace elements
       g_signal_connect(view.host()->im_context, "commit",
          G_CALLBACK(on_text_entry), &view);
 
-      // Create 1ms timer
-      g_timeout_add(1, poll_function, &view);
-
       return content_view;
    }
 
@@ -457,11 +679,9 @@ namespace cycfi { namespace elements
       }
    };
 
-   base_view::base_view(extent /* size_ */)
-    : base_view(new host_view)
+   base_view::base_view(extent size_)
+    : base_view(new host_view(size_))
    {
-      // $$$ FIXME: Implement Me $$$
-      CYCFI_ASSERT(false, "Unimplemented");
    }
 
    base_view::base_view(host_view_handle h)
@@ -499,6 +719,8 @@ namespace cycfi { namespace elements
 
    elements::extent base_view::size() const
    {
+      if (_view->offscreen)
+         return _view->offscreen_size;
       auto x = gtk_widget_get_allocated_width(_view->widget);
       auto y = gtk_widget_get_allocated_height(_view->widget);
       return { float(x), float(y) };
@@ -506,6 +728,17 @@ namespace cycfi { namespace elements
 
    void base_view::size(elements::extent p)
    {
+      if (_view->offscreen)
+      {
+         cairo_surface_destroy(_view->surface);
+         _view->offscreen_size = p;
+         _view->surface = cairo_image_surface_create(
+            CAIRO_FORMAT_ARGB32, p.width, p.height
+         );
+         refresh();
+         return;
+      }
+
       // $$$ Wrong: don't size the window!!! $$$
       gtk_window_resize(GTK_WINDOW(_view->widget), p.width, p.height);
    }
@@ -517,6 +750,11 @@ namespace cycfi { namespace elements
 
    void base_view::refresh()
    {
+      if (_view->offscreen)
+      {
+         refresh({ 0, 0, _view->offscreen_size.width, _view->offscreen_size.height });
+         return;
+      }
       auto x = gtk_widget_get_allocated_width(_view->widget);
       auto y = gtk_widget_get_allocated_height(_view->widget);
       refresh({ 0, 0, float(x), float(y) });
@@ -524,6 +762,9 @@ namespace cycfi { namespace elements
 
    void base_view::refresh(rect area)
    {
+      _view->dirty.add(area);
+      if (_view->offscreen)
+         return;
       gtk_widget_queue_draw_area(_view->widget,
          area.left,
          area.top,
@@ -532,6 +773,69 @@ namespace cycfi { namespace elements
       );
    }
 
+   namespace
+   {
+      void on_frame_update(GdkFrameClock* clock, gpointer user_data)
+      {
+         // The frame time is in microseconds, from the same monotonic
+         // clock as g_get_monotonic_time
+         using std::chrono::microseconds;
+         auto age = g_get_monotonic_time() - gdk_frame_clock_get_frame_time(clock);
+         auto& view = get(user_data);
+         dispatch_motion(view);
+         view.frame(
+            std::chrono::steady_clock::now() - microseconds(std::max<gint64>(age, 0))
+         );
+      }
+   }
+
+   bool base_view::request_frame()
+   {
+      if (_view->offscreen || !_view->widget)
+         return false;
+
+      if (!_view->frame_clock)
+      {
+         auto* clock = gtk_widget_get_frame_clock(_view->widget);
+         if (!clock) // not realized yet
+            return false;
+         _view->frame_clock = GDK_FRAME_CLOCK(g_object_ref(clock));
+         _view->frame_handler = g_signal_connect(clock, "update",
+            G_CALLBACK(on_frame_update), this);
+      }
+      gdk_frame_clock_request_phase(_view->frame_clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+      return true;
+   }
+
+   std::vector<point> const& base_view::motion_history() const
+   {
+      return _view->motion_history;
+   }
+
+   bool base_view::is_offscreen() const
+   {
+      return _view->offscreen;
+   }
+
+   cairo_surface_t* base_view::offscreen_surface() const
+   {
+      return _view->offscreen? _view->surface : nullptr;
+   }
+
+   void base_view::render()
+   {
+      if (!_view->offscreen || _view->dirty.empty())
+         return;
+
+      draw_dirty(*this, _view);
+      cairo_surface_flush(_view->surface);
+   }
+
+   void base_view::cursor_pos(point p)
+   {
+      _view->cursor_position = p;
+   }
+
    std::string clipboard()
    {
       GtkClipboard* clip = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
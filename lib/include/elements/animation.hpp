@@ -0,0 +1,210 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_ANIMATION_OCTOBER_17_2026)
+#define ELEMENTS_ANIMATION_OCTOBER_17_2026
+
+#include <elements/frame_clock.hpp>
+#include <elements/support/color.hpp>
+#include <elements/support/point.hpp>
+#include <elements/support/rect.hpp>
+#include <infra/support.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   class view;
+   class element;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Easing curves: map the linear progress t (0 to 1) to the eased
+   // progress.
+   ////////////////////////////////////////////////////////////////////////////
+   using easing_function = float(*)(float t);
+
+   namespace easing
+   {
+      float linear(float t);
+      float ease_in(float t);          // cubic
+      float ease_out(float t);         // cubic
+      float ease_in_out(float t);      // cubic
+      float ease_out_back(float t);    // overshoots, then settles
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Interpolation between two values, for t from 0 to 1
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   T interpolate(T const& a, T const& b, float t);
+
+   ////////////////////////////////////////////////////////////////////////////
+   // tween: animates a property from one value to another, over a
+   // duration, after a delay. apply is called with the eased progress,
+   // once per frame. target is the element refreshed after each step (the
+   // whole view is refreshed if there is none), held through a weak
+   // handle (see element::weak_handle). A tween whose target is destroyed
+   // is dropped, without calling apply or on_done again. on_done is called
+   // when the tween ends or is stopped.
+   ////////////////////////////////////////////////////////////////////////////
+   struct tween
+   {
+      using duration = frame_clock::clock_type::duration;
+      using apply_function = std::function<void(float t)>;
+      using done_function = std::function<void()>;
+
+      duration                length = {};
+      duration                delay = {};
+      easing_function         easing = easing::ease_in_out;
+      apply_function          apply;
+      std::weak_ptr<element*> target;
+      bool                    has_target = false;
+      done_function           on_done;
+
+      void                    set_target(element* e);
+   };
+
+   // Make a tween that calls set with the value interpolated from from to
+   // to, over the given duration
+   template <typename T, typename F, typename Duration>
+   tween make_tween(
+      T from
+    , T to
+    , Duration length
+    , F set
+    , element* target = nullptr
+    , easing_function easing_ = easing::ease_in_out
+   );
+
+   ////////////////////////////////////////////////////////////////////////////
+   // timeline: a group of tweens, each starting at an offset from the start
+   // of the timeline, played and stopped together.
+   ////////////////////////////////////////////////////////////////////////////
+   class timeline
+   {
+   public:
+
+      using duration = tween::duration;
+
+      timeline&               add(tween t, duration at = {});
+      timeline&               then(tween t);
+      duration                length() const { return _length; }
+      std::vector<tween>&     tweens() { return _tweens; }
+
+   private:
+
+      std::vector<tween>      _tweens;
+      duration                _length = {};
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // animator: plays tweens and timelines on a view, driven by the view's
+   // frame clock (see view::animator). It subscribes to the frame clock
+   // only while it has tweens to play. Each step refreshes only the
+   // tween's target element, and all the refreshes of a frame are painted
+   // together.
+   ////////////////////////////////////////////////////////////////////////////
+   class animator : non_copyable
+   {
+   public:
+
+      using id_type = std::uint64_t;
+      using time_point = frame_clock::time_point;
+
+                              animator(view& view_);
+                              ~animator();
+
+      id_type                 play(tween t);
+      id_type                 play(timeline t);
+      void                    stop(id_type id, bool finish = false);
+      bool                    is_playing() const { return !_tracks.empty(); }
+
+   private:
+
+      struct track
+      {
+         id_type              id;
+         tween                tween_;
+         time_point           start;
+         bool                 started;
+      };
+
+      using track_list = std::vector<track>;
+
+      bool                    frame(time_point t);
+      bool                    step(track& t, float progress);
+      void                    subscribe();
+
+      using stop_list = std::vector<std::pair<id_type, bool>>;
+
+      view&                   _view;
+      track_list              _tracks;
+      id_type                 _next_id = 1;
+      frame_clock::id_type    _subscription = 0;
+      bool                    _in_frame = false;
+      stop_list               _stops;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   inline T interpolate(T const& a, T const& b, float t)
+   {
+      return a + (b - a) * t;
+   }
+
+   template <>
+   inline point interpolate(point const& a, point const& b, float t)
+   {
+      return { interpolate(a.x, b.x, t), interpolate(a.y, b.y, t) };
+   }
+
+   template <>
+   inline rect interpolate(rect const& a, rect const& b, float t)
+   {
+      return {
+         interpolate(a.left, b.left, t)
+       , interpolate(a.top, b.top, t)
+       , interpolate(a.right, b.right, t)
+       , interpolate(a.bottom, b.bottom, t)
+      };
+   }
+
+   template <>
+   inline color interpolate(color const& a, color const& b, float t)
+   {
+      return {
+         interpolate(a.red, b.red, t)
+       , interpolate(a.green, b.green, t)
+       , interpolate(a.blue, b.blue, t)
+       , interpolate(a.alpha, b.alpha, t)
+      };
+   }
+
+   template <typename T, typename F, typename Duration>
+   inline tween make_tween(
+      T from
+    , T to
+    , Duration length
+    , F set
+    , element* target
+    , easing_function easing_
+   )
+   {
+      tween t;
+      t.length = std::chrono::duration_cast<tween::duration>(length);
+      t.easing = easing_;
+      t.apply = [from, to, set](float progress) { set(interpolate(from, to, progress)); };
+      t.set_target(target);
+      return t;
+   }
+}}
+
+#endif
@@ -7,10 +7,12 @@
 #define CYCFI_ELEMENTS_BASE_VIEW_AUGUST_20_2016
 
 #include <utility>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <cstdint>
 #include <functional>
+#include <vector>
 #include <cairo.h>
 
 #include <infra/support.hpp>
@@ -314,12 +316,39 @@ namespace cycfi { namespace elements
       virtual void         refresh();
       virtual void         refresh(rect area);
 
+      // Frames (see frame_clock.hpp). request_frame asks the host to call
+      // frame at its next frame. It returns false if the host has no frame
+      // clock.
+      using frame_time = std::chrono::steady_clock::time_point;
+      virtual void         frame(frame_time t);
+      bool                 request_frame();
+
       float                hdpi_scale() const;
       point                cursor_pos() const;
       extent               size() const;
       void                 size(extent size_);
       host_view_handle     host() const { return _view; }
 
+#if defined(ELEMENTS_HOST_UI_LIBRARY_GTK)
+      // Offscreen views: base_view(extent) creates a headless view with no
+      // window that needs no display server. It draws into an in-memory
+      // image surface (offscreen_surface). Events are synthesized by
+      // calling the event handlers (click, drag, cursor, scroll, key, text)
+      // directly; use cursor_pos(p) to set the position reported by
+      // cursor_pos(). refresh accumulates the dirty area, and render()
+      // draws it into the surface. Call view::poll() first to run posted
+      // tasks (e.g. refresh), and use view::manual_clock for deterministic
+      // view::post timers.
+      bool                 is_offscreen() const;
+      cairo_surface_t*     offscreen_surface() const;
+      void                 render();
+      void                 cursor_pos(point p);
+
+      // The positions of the coalesced motion events of the drag being
+      // dispatched, oldest first, ending with the drag's position
+      std::vector<point> const& motion_history() const;
+#endif
+
    private:
 
       host_view_handle     _view;
@@ -336,6 +365,11 @@ namespace cycfi { namespace elements
    inline void base_view::begin_focus() {}
    inline void base_view::end_focus() {}
    inline void base_view::poll() {}
+   inline void base_view::frame(frame_time /* t */) {}
+
+#if !defined(ELEMENTS_HOST_UI_LIBRARY_GTK)
+   inline bool base_view::request_frame() { return false; }
+#endif
 
    ////////////////////////////////////////////////////////////////////////////
    // The clipboard
@@ -8,6 +8,7 @@
 
 #include <elements/element/align.hpp>
 #include <elements/element/button.hpp>
+#include <elements/element/cached.hpp>
 #include <elements/element/composite.hpp>
 #include <elements/element/dial.hpp>
 #include <elements/element/dynamic_list.hpp>
@@ -0,0 +1,56 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_CACHED_OCTOBER_17_2026)
+#define ELEMENTS_CACHED_OCTOBER_17_2026
+
+#include <elements/element/proxy.hpp>
+#include <elements/support/pixmap.hpp>
+#include <infra/support.hpp>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Cached elements
+   //
+   // Renders the subject into a pixmap at the current device scale and
+   // bounds, and blits that pixmap on subsequent draws. The cache is
+   // invalidated when an element in the subject requests a refresh through
+   // its context (view::refresh(ctx) or view::refresh(element)), when the
+   // subject is laid out again, by invalidate_cache(), or when the bounds
+   // or the device transform change. Other refreshes (e.g. of a sibling
+   // overlapping the cache, or of the whole view) blit the pixmap. Use
+   // this for expensive, mostly static subtrees (e.g. panels with shadows,
+   // dial marks and labels).
+   ////////////////////////////////////////////////////////////////////////////
+   class cached_element : public proxy_base
+   {
+   public:
+
+      void                    draw(context const& ctx) override;
+      void                    layout(context const& ctx) override;
+      void                    invalidate_cache() { _valid = false; }
+
+   private:
+
+      using pixmap_ptr = std::unique_ptr<pixmap>;
+
+      pixmap_ptr              _pixmap;
+      rect                    _bounds;
+      rect                    _device_bounds;
+      point                   _device_scale;
+      bool                    _valid = false;
+   };
+
+   template <typename Subject>
+   inline proxy<remove_cvref_t<Subject>, cached_element>
+   cached(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+}}
+
+#endif
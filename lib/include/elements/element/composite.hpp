@@ -79,10 +79,24 @@ namespace cycfi { namespace elements
       virtual hit_info        hit_element(context const& ctx, point p, bool control) const;
       virtual rect            bounds_of(context const& ctx, std::size_t index) const = 0;
       virtual bool            reverse_index() const { return false; }
+      virtual bool            hit_preceding(context const& ctx, point p, std::size_t index) const;
+      int                     cursor_tracking_index() const { return _cursor_tracking; }
 
                               template <typename F>
       void                    for_each(F&& f, bool reverse = false) const;
 
+   protected:
+
+      bool                    hit_child(
+                                 context const& ctx, std::size_t index
+                               , point p, bool control, hit_info& info
+                              ) const;
+
+      hit_info                hit_range(
+                                 context const& ctx, point p, bool control
+                               , std::size_t first, std::size_t last
+                              ) const;
+
    private:
 
       void                    new_focus(context const& ctx, int index);
@@ -149,7 +149,7 @@ namespace cycfi { namespace elements
    inline view_limits
    radial_element_base<size, Subject>::limits(basic_context const& ctx) const
    {
-      auto sl = this->subject().limits(ctx);
+      auto sl = this->subject().cached_limits(ctx);
 
       sl.min.x += size;
       sl.max.x += size;
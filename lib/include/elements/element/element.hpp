@@ -13,6 +13,7 @@
 #include <infra/string_view.hpp>
 #include <memory>
 #include <type_traits>
+#include <cstdint>
 
 namespace cycfi { namespace elements
 {
@@ -61,11 +62,94 @@ namespace cycfi { namespace elements
 
       enum tracking { none, begin_tracking, while_tracking, end_tracking };
 
+   // Limits and layout cache
+
+      view_limits             cached_limits(basic_context const& ctx) const;
+      void                    update_layout(context const& ctx, std::size_t index = 0);
+      void                    invalidate_limits();
+      void                    invalidate_limits(context const& ctx);
+      void                    invalidate_layout();
+      element const*          layout_parent() const;
+      element*                layout_parent();
+      std::size_t             layout_index() const { return _layout_link.index; }
+      std::weak_ptr<element*> weak_handle();
+
    protected:
 
       void                    on_tracking(context const& ctx, tracking state);
+
+   private:
+
+      mutable view_limits     _cached_limits;
+      mutable std::uint32_t   _limits_generation = 0;
+      rect                    _layout_bounds;
+      std::uint32_t           _layout_generation = 0;
+
+      // The parent the element was last laid out in. An element shares an
+      // anchor (pointing to itself) with the links of its children, so
+      // the links expire when it is destroyed. Links and anchors are not
+      // copied with their elements.
+      using layout_anchor = std::shared_ptr<element*>;
+
+      struct layout_link
+      {
+                              layout_link() = default;
+                              layout_link(layout_link const&) {}
+         layout_link&         operator=(layout_link const&) { return *this; }
+
+         layout_anchor        anchor;
+         std::weak_ptr<element*> parent;
+         std::size_t          index = 0;
+      };
+
+      layout_link             _layout_link;
    };
 
+   ////////////////////////////////////////////////////////////////////////////
+   // Limits and layout cache
+   //
+   // Parents query the limits of their children through cached_limits,
+   // which memoizes the result of element::limits. Cached limits are valid
+   // only for the view's current limits generation: view::layout() and
+   // view::invalidate_all_limits() start a new one, invalidating all the
+   // limits cached for that view, and only that view.
+   //
+   // Anything that changes an element's limits must invalidate them. An
+   // element whose limits change while it is laid out (e.g. a text box
+   // that grows) should call invalidate_limits(ctx), which invalidates the
+   // element and all its ancestors up the context chain. Mutators called
+   // without a context (e.g. set_text) call invalidate_limits() on the
+   // element alone, and the client then calls view::layout(e), which
+   // invalidates its ancestors. When limits depend on external state (e.g.
+   // is_collapsed in collapsibles, or a dynamic_list's composer), the
+   // client must call view::layout(e) or view::layout() when it changes.
+   //
+   // Likewise, parents lay out their children through update_layout, which
+   // calls element::layout only if the element's layout was invalidated or
+   // if its bounds changed since the last layout. Invalidating an element's
+   // limits also invalidates its layout. invalidate_layout invalidates the
+   // layout only (e.g. when an element's internal positioning changes).
+   //
+   // update_layout also records the parent the element was last laid out
+   // in (layout_parent) and its index in that parent (layout_index). The
+   // view follows these up to find the path to an element to be refreshed
+   // or laid out again, so that only the elements along the path are
+   // visited. The link to the parent is weak: layout_parent() returns
+   // nullptr once the parent is destroyed. A link may be stale if the
+   // element was moved or removed since it was laid out, so users of the
+   // path check that each child is still where its link says.
+   //
+   // weak_handle() returns a weak pointer to the element's anchor. It works
+   // for elements held by value as well, and expires when the element is
+   // destroyed. Deferred tasks hold one instead of a raw pointer.
+   //
+   // layout_epoch() changes whenever any element's limits or layout is
+   // invalidated. Elements may use it to validate data derived from the
+   // layout of their children (e.g. spatial indexes).
+   ////////////////////////////////////////////////////////////////////////////
+   std::uint32_t  new_limits_generation();
+   std::uint32_t  layout_epoch();
+
    ////////////////////////////////////////////////////////////////////////////
    using element_ptr = std::shared_ptr<element>;
    using element_const_ptr = std::shared_ptr<element const>;
@@ -25,7 +25,7 @@ namespace cycfi { namespace elements
       void                    prepare_subject(context& ctx) override;
 
       rect                    bounds() const { return _bounds; }
-      void                    bounds(rect bounds_) { _bounds = bounds_; }
+      void                    bounds(rect bounds_) { _bounds = bounds_; invalidate_layout(); }
 
    private:
 
@@ -49,13 +49,20 @@ namespace cycfi { namespace elements
                               {}
 
       text_type               get_text() const override           { return _text; }
-      void                    set_text(string_view text) override { _text = std::string(text); }
+      void                    set_text(string_view text) override;
 
    private:
 
       std::string             _text;
    };
 
+   template <typename Base>
+   inline void basic_label_base<Base>::set_text(string_view text)
+   {
+      _text = std::string(text);
+      this->invalidate_limits();
+   }
+
    template <typename Base>
    struct label_with_font : Base
    {
@@ -8,6 +8,8 @@
 
 #include <elements/element/composite.hpp>
 #include <algorithm>
+#include <cstdint>
+#include <vector>
 
 namespace cycfi { namespace elements
 {
@@ -22,6 +24,7 @@ namespace cycfi { namespace elements
       void                    layout(context const& ctx) override;
       void                    draw(context const& ctx) override;
       hit_info                hit_element(context const& ctx, point p, bool control) const override;
+      bool                    hit_preceding(context const& ctx, point p, std::size_t index) const override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
       void                    begin_focus() override;
       bool                    reverse_index() const override { return true; }
@@ -30,8 +33,27 @@ namespace cycfi { namespace elements
 
    private:
 
+      // Bucket grid over the layer's bounds, mapping each cell to the
+      // (ascending) indices of the elements that may be hit there. Used
+      // by hit_element when the layer has many elements.
+      using bucket_type = std::vector<int>;
+
+      struct hit_index
+      {
+         rect                             bounds;
+         std::uint32_t                    epoch = 0;
+         std::size_t                      size = 0;
+         std::size_t                      columns = 0;
+         std::size_t                      rows = 0;
+         std::vector<bucket_type>         buckets;
+      };
+
       void                    focus_top();
+      void                    update_hit_index(context const& ctx) const;
+      bucket_type const*      hit_bucket(context const& ctx, point p) const;
+
       point                   _previous_size;
+      mutable hit_index       _hit_index;
    };
 
    using layer_composite = vector_composite<layer_element>;
@@ -60,6 +82,7 @@ namespace cycfi { namespace elements
       void                 draw(context const& ctx) override;
       void                 refresh(context const& ctx, element& element, int outward = 0) override;
       hit_info             hit_element(context const& ctx, point p, bool control) const override;
+      bool                 hit_preceding(context const&, point, std::size_t) const override { return false; }
       void                 begin_focus() override;
 
       using element::refresh;
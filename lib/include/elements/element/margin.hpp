@@ -42,7 +42,7 @@ namespace cycfi { namespace elements
    template <typename Rect, typename Subject>
    inline view_limits margin_element<Rect, Subject>::limits(basic_context const& ctx) const
    {
-      auto r = this->subject().limits(ctx);
+      auto r = this->subject().cached_limits(ctx);
 
       r.min.x += _margin.left + _margin.right;
       r.max.x += _margin.left + _margin.right;
@@ -52,7 +52,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float size_x = _size.width;
       float size_y = _size.height;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
@@ -104,7 +104,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits hsize_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float width = _width;
       clamp(width, e_limits.min.x, e_limits.max.x);
       return { { width, e_limits.min.y }, { width, e_limits.max.y } };
@@ -153,7 +153,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits vsize_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float height = _height;
       clamp(height, e_limits.min.y, e_limits.max.y);
       return { { e_limits.min.x, height }, { e_limits.max.x, height } };
@@ -204,7 +204,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits min_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float size_x = _size.x;
       float size_y = _size.y;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
@@ -258,7 +258,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits hmin_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float width = _width;
       clamp(width, e_limits.min.x, e_limits.max.x);
       return { { width, e_limits.min.y }, e_limits.max };
@@ -308,7 +308,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits vmin_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float height = _height;
       clamp(height, e_limits.min.y, e_limits.max.y);
       return { { e_limits.min.x, height }, e_limits.max };
@@ -360,7 +360,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits max_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float size_x = _size.x;
       float size_y = _size.y;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
@@ -414,7 +414,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits hmax_size_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float size_x = _size;
       clamp(size_x, e_limits.min.x, e_limits.max.x);
       return { { e_limits.min.x, e_limits.min.y }, { size_x, e_limits.max.y } };
@@ -590,7 +590,7 @@ namespace cycfi { namespace elements
    inline view_limits
    limit_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto l = this->subject().limits(ctx);
+      auto l = this->subject().cached_limits(ctx);
       clamp_min(l.min.x, _limits.min.x);
       clamp_min(l.min.y, _limits.min.y);
       clamp_max(l.max.x, _limits.max.x);
@@ -638,7 +638,7 @@ namespace cycfi { namespace elements
    inline view_limits
    scale_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto l = this->subject().limits(ctx);
+      auto l = this->subject().cached_limits(ctx);
       l.min.x *= _scale;
       l.min.y *= _scale;
       l.max.x *= _scale;
@@ -680,6 +680,9 @@ namespace cycfi { namespace elements
 
    ////////////////////////////////////////////////////////////////////////////
    // Collapsible
+   //
+   // The limits of a collapsible depend on is_collapsed. Call view::layout
+   // (or view::layout(e)) when it changes, to invalidate its cached limits.
    ////////////////////////////////////////////////////////////////////////////
    template <typename Subject>
    class hcollapsible_element : public proxy<Subject>
@@ -702,7 +705,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits hcollapsible_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = this->subject().cached_limits(ctx);
       if (is_collapsed())
          e_limits.min.x = e_limits.max.x = 0;
       return e_limits;
@@ -737,7 +740,7 @@ namespace cycfi { namespace elements
    template <typename Subject>
    inline view_limits vcollapsible_element<Subject>::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = this->subject().cached_limits(ctx);
       if (is_collapsed())
          e_limits.min.y = e_limits.max.y = 0;
       return e_limits;
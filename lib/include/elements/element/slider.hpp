@@ -277,7 +277,7 @@ namespace cycfi { namespace elements
    inline view_limits
    slider_element_base<size, Subject>::limits(basic_context const& ctx) const
    {
-      auto sl = this->subject().limits(ctx);
+      auto sl = this->subject().cached_limits(ctx);
       if (sl.min.x < sl.min.y) // is vertical?
       {
          sl.min.x += size;
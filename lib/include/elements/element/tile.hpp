@@ -22,6 +22,8 @@ namespace cycfi { namespace elements
       void                    draw(context const& ctx) override;
       void                    layout(context const& ctx) override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
+      hit_info                hit_element(context const& ctx, point p, bool control) const override;
+      bool                    hit_preceding(context const&, point, std::size_t) const override { return false; }
 
    private:
 
@@ -51,6 +53,8 @@ namespace cycfi { namespace elements
       void                    draw(context const& ctx) override;
       void                    layout(context const& ctx) override;
       rect                    bounds_of(context const& ctx, std::size_t index) const override;
+      hit_info                hit_element(context const& ctx, point p, bool control) const override;
+      bool                    hit_preceding(context const&, point, std::size_t) const override { return false; }
 
    private:
 
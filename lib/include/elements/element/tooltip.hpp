@@ -45,6 +45,7 @@ namespace cycfi { namespace elements
       popup_ptr               _tip;
       status                  _tip_status = tip_hidden;
       duration                _delay;
+      view::timer_id          _delay_timer;
       bool                    _cursor_in_tip = false;
    };
 
@@ -0,0 +1,67 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_FRAME_CLOCK_OCTOBER_17_2026)
+#define ELEMENTS_FRAME_CLOCK_OCTOBER_17_2026
+
+#include <infra/support.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // frame_clock: delivers a tick per frame to its subscribers, with the
+   // frame's timestamp. A subscriber is called every frame for as long as
+   // it returns true, or until it is removed. The clock runs only while it
+   // has subscribers: it calls request_frame when it needs another frame.
+   //
+   // A view's frame clock (view::frame_clock) is driven by the host's
+   // frame clock when it has one (GdkFrameClock with GTK), and by a
+   // synthetic clock otherwise (e.g. offscreen views). Refreshes requested
+   // while the clock is running are batched, and painted once per frame.
+   ////////////////////////////////////////////////////////////////////////////
+   class frame_clock : non_copyable
+   {
+   public:
+
+      using clock_type = std::chrono::steady_clock;
+      using time_point = clock_type::time_point;
+      using frame_function = std::function<bool(time_point t)>;
+      using request_function = std::function<void()>;
+      using id_type = std::uint64_t;
+
+                              frame_clock(request_function request_frame);
+
+      id_type                 add(frame_function f);
+      void                    remove(id_type id);
+
+      bool                    is_running() const { return !_subscribers.empty(); }
+      time_point              frame_time() const { return _frame_time; }
+
+      void                    tick(time_point t);
+
+   private:
+
+      struct subscriber
+      {
+         id_type              id;
+         frame_function       f;
+         bool                 active;
+      };
+
+      using subscriber_list = std::vector<subscriber>;
+
+      request_function        _request_frame;
+      subscriber_list         _subscribers;
+      id_type                 _next_id = 1;
+      time_point              _frame_time;
+      bool                    _in_tick = false;
+   };
+}}
+
+#endif
@@ -0,0 +1,267 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_SCHEDULER_OCTOBER_17_2026)
+#define ELEMENTS_SCHEDULER_OCTOBER_17_2026
+
+#include <elements/support/mpsc_queue.hpp>
+#include <infra/support.hpp>
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Scheduler
+   //
+   // The app-wide scheduler shared by all views (see app_scheduler()). It
+   // owns the views' task queues and a hashed timer wheel. A single wakeup
+   // of the host's main loop (see wake_main_loop) runs the expired timers,
+   // then drains all the task queues with pending tasks.
+   //
+   // Timers are rounded up to the wheel's tick (one 60 Hz frame), so all
+   // the timers that expire in the same frame run in the same wakeup.
+   // post_tick aligns the timer to a shared periodic clock instead (e.g.
+   // the caret blink or animation frames), so that all the timers posted
+   // with the same period expire together.
+   //
+   // Tasks are posted with a priority. Each wakeup runs the input tasks of
+   // all the queues first, then the layout tasks, the paint tasks and the
+   // normal tasks. Idle tasks (see task_queue::post_idle) run last, only
+   // for what remains of the frame's idle budget (idle_budget), and resume
+   // in the next frame.
+   //
+   // Notifications (see task_queue::notify) are posted from other threads
+   // without locking or allocating. They run at the start of the wakeup,
+   // before the prioritized tasks.
+   //
+   // The asio io_context (io()) is kept for clients that need it. Posting
+   // to it does not wake the main loop by itself, so io() wakes it, and
+   // each wakeup schedules the next one in io_poll_interval for as long as
+   // the io_context has work (pending handlers or asio timers). Get the
+   // io_context through io() for each use, rather than keeping a
+   // reference to post to later.
+   ////////////////////////////////////////////////////////////////////////////
+   class scheduler : non_copyable
+   {
+   public:
+
+      using task = std::function<void()>;
+      using idle_task = std::function<bool()>;
+      using io_context = asio::io_context;
+      using clock_type = std::chrono::steady_clock;
+      using duration = clock_type::duration;
+      using time_point = clock_type::time_point;
+
+      enum priority { input, layout, paint, normal, num_priorities };
+
+      /////////////////////////////////////////////////////////////////////////
+      // notification: a task posted with task_queue::notify. Its function
+      // object is stored inline, so it must be trivially copyable, and no
+      // larger than max_size.
+      class notification
+      {
+      public:
+
+         static constexpr std::size_t max_size = 48;
+
+                              notification() = default;
+
+                              template <typename F>
+                              notification(void const* key, F f);
+
+         void const*          key() const { return _key; }
+         void                 operator()() const { _invoke(&_storage); }
+
+      private:
+
+         using invoke_function = void(*)(void const* f);
+         using storage = std::aligned_storage_t<max_size, alignof(std::max_align_t)>;
+
+         void const*          _key = nullptr;
+         invoke_function      _invoke = nullptr;
+         storage              _storage;
+      };
+
+      static constexpr std::size_t notification_capacity = 1024;
+
+      /////////////////////////////////////////////////////////////////////////
+      // task_queue: a queue of tasks (e.g. for a view). post may be called
+      // from any thread. Tasks run in the main thread, in priority order,
+      // then in the order they were posted. An idle task is called again
+      // (possibly in a later frame) for as long as it returns true. Tasks
+      // pending when the queue is closed are discarded.
+      class task_queue
+       : non_copyable
+       , public std::enable_shared_from_this<task_queue>
+      {
+      public:
+                              task_queue(scheduler& s);
+
+         void                 post(task f, priority p = normal);
+         void                 post_idle(idle_task f);
+         void                 close();
+
+                              template <typename F>
+         bool                 notify(void const* key, F f);
+
+      private:
+
+         friend class scheduler;
+         using task_list = std::vector<task>;
+         using idle_list = std::vector<idle_task>;
+
+         void                 mark_ready();
+         bool                 is_closed();
+         void                 start_run();
+         void                 run(priority p);
+         bool                 run_idle(time_point deadline);
+         bool                 push_notification(notification const& n);
+         void                 run_notifications();
+
+         using notification_queue = mpsc_queue<notification>;
+         using notification_list = std::vector<notification>;
+         using key_map = std::unordered_map<void const*, std::size_t>;
+
+         scheduler&           _scheduler;
+         std::mutex           _mutex;
+         task_list            _tasks[num_priorities];
+         task_list            _running[num_priorities];
+         idle_list            _idle;
+         idle_list            _running_idle;
+         bool                 _is_ready = false;
+         bool                 _is_closed = false;
+
+         notification_queue   _notifications{ notification_capacity };
+         std::atomic<bool>    _has_notifications{ false };
+         notification_list    _running_notifications;
+         key_map              _last_notification;
+      };
+
+      using task_queue_ptr = std::shared_ptr<task_queue>;
+
+      /////////////////////////////////////////////////////////////////////////
+      // timer_id: identifies a pending timer, for cancel
+      struct timer_id
+      {
+         explicit             operator bool() const { return id != 0; }
+
+         std::uint64_t        id = 0;
+         std::uint64_t        tick = 0;
+      };
+
+      static constexpr duration tick_duration = std::chrono::microseconds{ 16667 };
+      static constexpr std::size_t wheel_size = 512;
+      static constexpr duration io_poll_interval = std::chrono::milliseconds{ 1 };
+
+                              scheduler();
+
+      io_context&             io();
+      task_queue_ptr          make_queue();
+      void                    poll();
+      time_point              next_wake() const;
+
+      duration                idle_budget() const { return _idle_budget; }
+      void                    idle_budget(duration budget) { _idle_budget = budget; }
+
+      timer_id                post(std::weak_ptr<task_queue> q, duration d, task f);
+      timer_id                post_tick(std::weak_ptr<task_queue> q, duration period, task f);
+      bool                    cancel(timer_id id);
+
+   private:
+
+      void                    ready(std::shared_ptr<task_queue> q);
+      void                    notified();
+      void                    run_notifications();
+      timer_id                post_at(std::weak_ptr<task_queue> q, time_point t, task f);
+      void                    run_timers();
+
+      struct timer
+      {
+         std::uint64_t              id;
+         std::uint64_t              tick;
+         std::weak_ptr<task_queue>  queue;
+         task                       f;
+      };
+
+      using wheel_slot = std::vector<timer>;
+
+      time_point              _epoch;
+      std::uint64_t           _current_tick = 0;
+      std::uint64_t           _next_timer_id = 1;
+      std::size_t             _num_timers = 0;
+      wheel_slot              _wheel[wheel_size];
+
+      io_context              _io;
+
+      using ready_list = std::vector<std::weak_ptr<task_queue>>;
+      std::mutex              _ready_mutex;
+      ready_list              _ready;
+      ready_list              _running;
+      ready_list              _idle;
+      std::vector<task_queue_ptr> _queues;
+      ready_list              _all_queues;
+      std::atomic<bool>       _is_notified{ false };
+      bool                    _is_polling = false;
+      duration                _idle_budget = std::chrono::milliseconds{ 4 };
+   };
+
+   scheduler& app_scheduler();
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Waking the main loop
+   //
+   // The host calls app_scheduler().poll() from its main loop, then waits
+   // until app_scheduler().next_wake() (the next timer, idle or io_context
+   // work, if any). wake_main_loop() asks for a call as soon as possible.
+   // It may be called from any thread, and must not lock.
+   // wake_main_loop(t) asks for a call at time t (e.g. for a timer posted
+   // between calls), and must be called from the main thread. Hosts that
+   // poll periodically ignore these.
+   ////////////////////////////////////////////////////////////////////////////
+   void wake_main_loop();
+   void wake_main_loop(scheduler::clock_type::time_point t);
+
+#if !defined(ELEMENTS_HOST_UI_LIBRARY_GTK)
+   inline void wake_main_loop() {}
+   inline void wake_main_loop(scheduler::clock_type::time_point /* t */) {}
+#endif
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename F>
+   inline scheduler::notification::notification(void const* key, F f)
+    : _key(key)
+    , _invoke([](void const* f_) { (*static_cast<F const*>(f_))(); })
+   {
+      static_assert(std::is_trivially_copyable<F>::value,
+         "notification functions must be trivially copyable");
+      static_assert(sizeof(F) <= max_size && alignof(F) <= alignof(storage),
+         "notification function is too large");
+      new (&_storage) F(f);
+   }
+
+   // Post f from any thread, without locking or allocating. Of the pending
+   // notifications with the same (non-null) key, only the last one runs.
+   // Returns false if the queue is full.
+   template <typename F>
+   inline bool scheduler::task_queue::notify(void const* key, F f)
+   {
+      return push_notification(notification{ key, f });
+   }
+}}
+
+#endif
@@ -15,11 +15,14 @@
 #include <elements/support/font.hpp>
 #include <elements/support/glyphs.hpp>
 #include <elements/support/icon_ids.hpp>
+#include <elements/support/mpsc_queue.hpp>
 #include <elements/support/pixmap.hpp>
 #include <elements/support/point.hpp>
 #include <elements/support/rect.hpp>
+#include <elements/support/region.hpp>
 #include <elements/support/draw_utils.hpp>
 #include <elements/support/text_utils.hpp>
 #include <elements/support/theme.hpp>
+#include <elements/support/trace.hpp>
 
 #endif
@@ -8,13 +8,17 @@
 
 #include <elements/support/color.hpp>
 #include <elements/support/rect.hpp>
+#include <elements/support/region.hpp>
 #include <elements/support/circle.hpp>
 #include <elements/support/pixmap.hpp>
 #include <elements/support/font.hpp>
 #include <infra/filesystem.hpp>
 
+#include <array>
 #include <vector>
 #include <functional>
+#include <initializer_list>
+#include <memory>
 #include <stack>
 #include <cmath>
 #include <cassert>
@@ -22,6 +26,9 @@
 extern "C"
 {
    typedef struct _cairo cairo_t;
+   typedef struct _cairo_pattern cairo_pattern_t;
+   typedef struct _cairo_matrix cairo_matrix_t;
+   typedef struct cairo_path cairo_path_t;
 }
 
 namespace cycfi { namespace elements
@@ -50,6 +57,23 @@ namespace cycfi { namespace elements
       point             device_to_user(point p);
       point             user_to_device(point p);
 
+      ///////////////////////////////////////////////////////////////////////////////////
+      // Damage: the region being redrawn, in device coordinates. Drawing
+      // outside the damage is clipped. Canvases with no damage (e.g.
+      // pixmap canvases) draw everything. user_damage is the damage in
+      // user coordinates (null if there is no damage). It is cached, and
+      // recomputed only when the transform changes.
+      //
+      // Painters may draw up to overdraw_margin outside their bounds (e.g.
+      // panel shadows). is_damaged inflates r by that much, so that the
+      // elements whose painting reaches into the damage are redrawn.
+      static constexpr float overdraw_margin = 8;
+
+      void              damage(region const* damage_);
+      region const*     damage() const { return _damage; }
+      region const*     user_damage();
+      bool              is_damaged(elements::rect r);
+
       ///////////////////////////////////////////////////////////////////////////////////
       // Paths
       void              begin_path();
@@ -75,6 +99,38 @@ namespace cycfi { namespace elements
       void              round_rect(elements::rect r, float radius);
       void              circle(elements::circle c);
 
+      ///////////////////////////////////////////////////////////////////////////////////
+      // Reusable paths: build a path once with make_path (or copy the
+      // current path with copy_path), then replay it with add_path instead
+      // of recomputing its geometry every frame. add_path can transform
+      // the path as it replays it: the path is scaled, then rotated (in
+      // radians), then offset. Paths are immutable: copies share the same
+      // path data.
+      class path
+      {
+      public:
+
+         bool              empty() const { return !_path; }
+         elements::rect    bounds() const { return _bounds; }
+         bool              includes(point p) const;
+
+      private:
+
+         friend class canvas;
+
+         std::shared_ptr<cairo_path_t> _path;
+         elements::rect    _bounds;
+      };
+
+      static path       make_path(std::function<void(canvas&)> const& build);
+      path              copy_path() const;
+      void              add_path(path const& p);
+      void              add_path(path const& p, point offset);
+      void              add_path(
+                           path const& p, point offset
+                         , float rotation, point scale = { 1, 1 }
+                        );
+
       ///////////////////////////////////////////////////////////////////////////////////
       // Styles
       void              fill_style(color c);
@@ -109,8 +165,20 @@ namespace cycfi { namespace elements
          std::vector<color_stop> space = {};
       };
 
+      // Gradient patterns are cached. Gradients with the same color stops
+      // and the same shape (normalized to a unit box) share one pattern,
+      // transformed to the gradient's geometry when used. With the color
+      // stops passed directly, a cached gradient is set without allocating.
+      using color_stops = std::initializer_list<color_stop>;
+
       void              fill_style(linear_gradient const& gr);
       void              fill_style(radial_gradient const& gr);
+      void              fill_linear_gradient(point start, point end, color_stops stops);
+      void              fill_radial_gradient(
+                           point c1, float c1_radius,
+                           point c2, float c2_radius,
+                           color_stops stops
+                        );
 
       enum fill_rule_enum
       {
@@ -198,22 +266,69 @@ namespace cycfi { namespace elements
       void              apply_fill_style();
       void              apply_stroke_style();
 
+      void              fill_linear_gradient(point start, point end, color_stop const* stops, std::size_t num_stops);
+      void              fill_radial_gradient(
+                           point c1, float c1_radius,
+                           point c2, float c2_radius,
+                           color_stop const* stops, std::size_t num_stops
+                        );
+
+      // A fill or stroke style: nothing, a solid color, or a cairo pattern
+      // (e.g. a gradient), optionally transformed from the pattern's unit
+      // box. Copying a style does not allocate: patterns are reference
+      // counted by cairo.
+      class style
+      {
+      public:
+                                 style() = default;
+                                 style(color c);
+         explicit                style(cairo_pattern_t* pattern); // adopts pattern
+                                 style(cairo_pattern_t* pattern, cairo_matrix_t const& transform);
+                                 style(style const& rhs);
+                                 style(style&& rhs) noexcept;
+                                 ~style();
+
+         style&                  operator=(style rhs) noexcept;
+         explicit                operator bool() const { return _kind != none; }
+         void                    apply(cairo_t& context_) const;
+
+      private:
+
+         enum kind_type { none, solid, pattern };
+
+         kind_type               _kind = none;
+         color                   _color;
+         cairo_pattern_t*        _pattern = nullptr;
+         bool                    _has_transform = false;
+         double                  _transform[6] = {};
+      };
+
       struct canvas_state
       {
-         std::function<void()>   stroke_style;
-         std::function<void()>   fill_style;
+         style                   stroke_style;
+         style                   fill_style;
          int                     align          = 0;
 
          enum pattern_state { none_set, stroke_set, fill_set };
          pattern_state           pattern_set = none_set;
       };
 
-      using state_stack = std::stack<canvas_state>;
+      // The saved states. The first max_saved_states are kept in a fixed
+      // array; deeper nesting spills into the overflow vector.
+      static constexpr std::size_t max_saved_states = 32;
+      using state_array = std::array<canvas_state, max_saved_states>;
+      using state_overflow = std::vector<canvas_state>;
 
       cairo_t&          _context;
       canvas_state      _state;
-      state_stack       _state_stack;
+      state_array       _saved_states;
+      std::size_t       _num_saved_states = 0;
+      state_overflow    _state_overflow;
       float             _pre_scale = 1.0f;
+      region const*     _damage = nullptr;
+      region            _user_damage;
+      double            _user_damage_matrix[6] = {};
+      bool              _user_damage_valid = false;
    };
 }}
 
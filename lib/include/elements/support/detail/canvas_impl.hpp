@@ -106,7 +106,7 @@ namespace cycfi { namespace elements
    {
       if (_state.pattern_set != _state.fill_set && _state.fill_style)
       {
-         _state.fill_style();
+         _state.fill_style.apply(_context);
          _state.pattern_set = _state.fill_set;
       }
    }
@@ -115,7 +115,7 @@ namespace cycfi { namespace elements
    {
       if (_state.pattern_set != _state.stroke_set && _state.stroke_style)
       {
-         _state.stroke_style();
+         _state.stroke_style.apply(_context);
          _state.pattern_set = _state.stroke_set;
       }
    }
@@ -14,9 +14,14 @@ namespace cycfi { namespace elements { namespace detail
    {
    public:
 
+      class scope;
+
       scratch_context()
       {
-         _surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+         // A zero-size target: measurement needs no pixels, and anything
+         // painted while measuring is clipped away instead of accumulating
+         // (as it would in a recording surface).
+         _surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 0, 0);
          _context = cairo_create(_surface);
       }
 
@@ -35,6 +40,62 @@ namespace cycfi { namespace elements { namespace detail
       cairo_surface_t*  _surface;
       cairo_t*          _context;
    };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // scratch_context::scope saves the state of the scratch context and
+   // resets it (identity transform, no path, no clip) so it can be reused
+   // for measurement instead of creating a new surface and context. The
+   // previous state is restored when the scope exits, so scopes may nest.
+   // cairo_save does not save the current path, so the scope copies the
+   // path in progress, if any, and puts it back on exit.
+   ////////////////////////////////////////////////////////////////////////////
+   class scratch_context::scope
+   {
+   public:
+
+      explicit scope(scratch_context& scratch)
+       : _context(scratch.context())
+       , _path(cairo_has_current_point(_context)? cairo_copy_path(_context) : nullptr)
+      {
+         cairo_save(_context);
+         cairo_identity_matrix(_context);
+         cairo_new_path(_context);
+         cairo_reset_clip(_context);
+      }
+
+      ~scope()
+      {
+         cairo_restore(_context);
+         cairo_new_path(_context);
+         if (_path)
+         {
+            if (_path->status == CAIRO_STATUS_SUCCESS)
+               cairo_append_path(_context, _path);
+            cairo_path_destroy(_path);
+         }
+      }
+
+      scope(scope const&) = delete;
+      scope& operator=(scope const&) = delete;
+
+      cairo_t*          context() const { return _context; }
+
+   private:
+
+      cairo_t*          _context;
+      cairo_path_t*     _path;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // The shared scratch context, used for measuring (e.g. glyph metrics and
+   // the views' limits, layout and event handling). Not thread safe: use
+   // only from the UI thread.
+   ////////////////////////////////////////////////////////////////////////////
+   inline scratch_context& shared_scratch_context()
+   {
+      static scratch_context scratch;
+      return scratch;
+   }
 }}}
 
 #endif
@@ -21,6 +21,10 @@ namespace cycfi::elements
 
    void  draw_box_vgradient(canvas& cnv, rect bounds, float corner_radius = 4.0);
    void  draw_panel(canvas& cnv, rect bounds, color c, float corner_radius = 4.0);
+   void  draw_shadow(
+            canvas& cnv, rect bounds, float corner_radius, float blur, color c
+          , bool draw_center = true
+         );
    void  draw_button(canvas& cnv, rect bounds, color c, float corner_radius = 4.0);
    void  draw_knob(canvas& cnv, circle cp, color c);
    void  draw_indicator(canvas& cnv, rect bounds, color c);
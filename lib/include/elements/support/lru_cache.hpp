@@ -0,0 +1,92 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_LRU_CACHE_OCTOBER_17_2026)
+#define ELEMENTS_LRU_CACHE_OCTOBER_17_2026
+
+#include <infra/support.hpp>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <utility>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // lru_cache: a cache of up to capacity values, keyed by Key (ordered by
+   // Compare). get(key, make) returns the value for key, calling make()
+   // to make it if it is not cached. When the cache is full, the least
+   // recently used value is dropped to make room. References to a value
+   // stay valid until it is dropped.
+   //
+   // lru_cache is not thread safe. The drawing caches (e.g. gradient
+   // patterns, paths and shadow atlases) are used from the main thread
+   // only, while drawing, and are kept in function-local statics.
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename Key, typename Value, typename Compare = std::less<Key>>
+   class lru_cache : non_copyable
+   {
+   public:
+
+      explicit             lru_cache(std::size_t capacity);
+
+                           template <typename F>
+      Value&               get(Key const& key, F&& make);
+
+      std::size_t          size() const { return _entries.size(); }
+      std::size_t          capacity() const { return _capacity; }
+      void                 clear();
+
+   private:
+
+      using entry = std::pair<Key, Value>;
+      using entry_list = std::list<entry>;
+      using index_map = std::map<Key, typename entry_list::iterator, Compare>;
+
+      std::size_t          _capacity;
+      entry_list           _entries;   // most recently used first
+      index_map            _index;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename Key, typename Value, typename Compare>
+   inline lru_cache<Key, Value, Compare>::lru_cache(std::size_t capacity)
+    : _capacity(capacity > 0? capacity : 1)
+   {}
+
+   template <typename Key, typename Value, typename Compare>
+   template <typename F>
+   inline Value& lru_cache<Key, Value, Compare>::get(Key const& key, F&& make)
+   {
+      if (auto i = _index.find(key); i != _index.end())
+      {
+         _entries.splice(_entries.begin(), _entries, i->second);
+         return i->second->second;
+      }
+
+      // Make the value before dropping anything, in case make throws
+      Value val = make();
+      if (_entries.size() == _capacity)
+      {
+         _index.erase(_entries.back().first);
+         _entries.pop_back();
+      }
+      _entries.emplace_front(key, std::move(val));
+      _index.emplace(key, _entries.begin());
+      return _entries.front().second;
+   }
+
+   template <typename Key, typename Value, typename Compare>
+   inline void lru_cache<Key, Value, Compare>::clear()
+   {
+      _index.clear();
+      _entries.clear();
+   }
+}}
+
+#endif
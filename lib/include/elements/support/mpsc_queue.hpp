@@ -0,0 +1,125 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_MPSC_QUEUE_OCTOBER_17_2026)
+#define ELEMENTS_MPSC_QUEUE_OCTOBER_17_2026
+
+#include <infra/support.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // mpsc_queue: a bounded, lock-free, multiple producer, single consumer
+   // queue of trivially copyable values (after Dmitry Vyukov's bounded
+   // MPMC queue). push may be called from any thread, and never locks or
+   // allocates. It returns false if the queue is full. pop must be called
+   // from a single (consumer) thread. capacity is rounded up to a power of
+   // two.
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   class mpsc_queue : non_copyable
+   {
+   public:
+
+      static_assert(std::is_trivially_copyable<T>::value,
+         "mpsc_queue values must be trivially copyable");
+
+      explicit             mpsc_queue(std::size_t capacity);
+
+      bool                 push(T const& val);
+      bool                 pop(T& val);
+      std::size_t          capacity() const { return _mask + 1; }
+
+   private:
+
+      struct cell
+      {
+         std::atomic<std::size_t>   sequence;
+         T                          data;
+      };
+
+      static std::size_t   round_capacity(std::size_t capacity);
+
+      std::size_t          _mask;
+      std::unique_ptr<cell[]> _buffer;
+
+      // Keep the producers' and the consumer's positions on separate cache
+      // lines
+      alignas(64) std::atomic<std::size_t> _push_pos{ 0 };
+      alignas(64) std::size_t _pop_pos = 0;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   inline std::size_t mpsc_queue<T>::round_capacity(std::size_t capacity)
+   {
+      std::size_t n = 2;
+      while (n < capacity)
+         n *= 2;
+      return n;
+   }
+
+   template <typename T>
+   inline mpsc_queue<T>::mpsc_queue(std::size_t capacity)
+    : _mask(round_capacity(capacity) - 1)
+    , _buffer(new cell[_mask + 1])
+   {
+      for (std::size_t i = 0; i <= _mask; ++i)
+         _buffer[i].sequence.store(i, std::memory_order_relaxed);
+   }
+
+   template <typename T>
+   inline bool mpsc_queue<T>::push(T const& val)
+   {
+      cell* c;
+      auto pos = _push_pos.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         c = &_buffer[pos & _mask];
+         auto seq = c->sequence.load(std::memory_order_acquire);
+         auto diff = std::intptr_t(seq) - std::intptr_t(pos);
+         if (diff == 0)
+         {
+            // The cell is free: claim it
+            if (_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+               break;
+         }
+         else if (diff < 0)
+         {
+            return false; // full
+         }
+         else
+         {
+            // Another producer claimed the cell
+            pos = _push_pos.load(std::memory_order_relaxed);
+         }
+      }
+      c->data = val;
+      c->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   template <typename T>
+   inline bool mpsc_queue<T>::pop(T& val)
+   {
+      auto& c = _buffer[_pop_pos & _mask];
+      auto seq = c.sequence.load(std::memory_order_acquire);
+      if (std::intptr_t(seq) - std::intptr_t(_pop_pos + 1) < 0)
+         return false; // empty
+      val = c.data;
+      c.sequence.store(_pop_pos + _mask + 1, std::memory_order_release);
+      ++_pop_pos;
+      return true;
+   }
+}}
+
+#endif
@@ -0,0 +1,76 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_REGION_OCTOBER_17_2026)
+#define ELEMENTS_REGION_OCTOBER_17_2026
+
+#include <elements/support/rect.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // region: an area made of a small list of rectangles, used for damage
+   // (the area of a view that needs to be redrawn). Overlapping rectangles
+   // are merged as they are added. When there are more than max_rects,
+   // the two rectangles that waste the least area when merged are merged,
+   // so that the region stays small while disjoint damage (e.g. at
+   // opposite corners of a view) stays disjoint.
+   ////////////////////////////////////////////////////////////////////////////
+   class region
+   {
+   public:
+
+      using rect_list = std::vector<rect>;
+      static constexpr std::size_t max_rects = 16;
+
+                              region() = default;
+                              region(rect r) { add(r); }
+
+      void                    add(rect r);
+      void                    add(region const& r);
+      void                    clear();
+
+      bool                    empty() const { return _rects.empty(); }
+      bool                    intersects(rect r) const;
+      rect                    bounds() const { return _bounds; }
+      rect_list const&        rects() const { return _rects; }
+
+   private:
+
+      void                    merge_cheapest();
+
+      rect_list               _rects;
+      rect                    _bounds;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   inline void region::add(region const& r)
+   {
+      for (auto const& r_ : r._rects)
+         add(r_);
+   }
+
+   inline void region::clear()
+   {
+      _rects.clear();
+      _bounds = {};
+   }
+
+   inline bool region::intersects(rect r) const
+   {
+      if (!_bounds.is_intersects(r))
+         return false;
+      for (auto const& r_ : _rects)
+         if (r_.is_intersects(r))
+            return true;
+      return false;
+   }
+}}
+
+#endif
@@ -0,0 +1,92 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TRACE_OCTOBER_17_2026)
+#define ELEMENTS_TRACE_OCTOBER_17_2026
+
+#include <infra/filesystem.hpp>
+#include <atomic>
+#include <chrono>
+#include <typeinfo>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Tracing
+   //
+   // Instrumentation zones (e.g. view::draw, layout, each element's draw)
+   // are recorded while tracing is on, and written to a Chrome trace JSON
+   // file (viewable in chrome://tracing or Perfetto) when tracing stops.
+   // Tracing is started by start_tracing, or at startup if the
+   // ELEMENTS_TRACE environment variable is set to the output file path.
+   // It stops at exit, if not stopped earlier by stop_tracing.
+   ////////////////////////////////////////////////////////////////////////////
+   void              start_tracing(fs::path const& path);
+   void              stop_tracing();
+   bool              is_tracing();
+
+   ////////////////////////////////////////////////////////////////////////////
+   // trace_zone records the time from its construction to its destruction.
+   // name and category must have static storage duration (e.g. string
+   // literals). A zone may also be named by a dynamic type (e.g. the type
+   // of an element being drawn).
+   ////////////////////////////////////////////////////////////////////////////
+   class trace_zone
+   {
+   public:
+
+      explicit          trace_zone(char const* name, char const* category = "elements");
+      explicit          trace_zone(std::type_info const& type, char const* category = "elements");
+                        ~trace_zone();
+
+                        trace_zone(trace_zone const&) = delete;
+      trace_zone&       operator=(trace_zone const&) = delete;
+
+   private:
+
+      using time_point = std::chrono::steady_clock::time_point;
+
+      char const*       _name;
+      char const*       _category;
+      bool              _is_type;
+      bool              _active;
+      time_point        _start;
+   };
+
+   namespace detail
+   {
+      extern std::atomic<bool> tracing_on;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   inline bool is_tracing()
+   {
+      return detail::tracing_on.load(std::memory_order_relaxed);
+   }
+
+   inline trace_zone::trace_zone(char const* name, char const* category)
+    : _name(name)
+    , _category(category)
+    , _is_type(false)
+    , _active(is_tracing())
+   {
+      if (_active)
+         _start = std::chrono::steady_clock::now();
+   }
+
+   inline trace_zone::trace_zone(std::type_info const& type, char const* category)
+    : _name(type.name())
+    , _category(category)
+    , _is_type(true)
+    , _active(is_tracing())
+   {
+      if (_active)
+         _start = std::chrono::steady_clock::now();
+   }
+}}
+
+#endif
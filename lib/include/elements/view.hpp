@@ -6,7 +6,10 @@
 #if !defined(ELEMENTS_VIEW_AUGUST_15_2016)
 #define ELEMENTS_VIEW_AUGUST_15_2016
 
+#include <elements/animation.hpp>
 #include <elements/base_view.hpp>
+#include <elements/frame_clock.hpp>
+#include <elements/scheduler.hpp>
 #include <elements/support/rect.hpp>
 #include <elements/support/canvas.hpp>
 #include <elements/support/theme.hpp>
@@ -14,10 +17,15 @@
 #include <elements/element/layer.hpp>
 #include <elements/element/size.hpp>
 #include <elements/element/indirect.hpp>
-#include <asio.hpp>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <chrono>
+#include <vector>
+#include <map>
+#include <functional>
+#include <thread>
 
 namespace cycfi { namespace elements
 {
@@ -43,17 +51,29 @@ namespace cycfi { namespace elements
       void                    begin_focus() override;
       void                    end_focus() override;
       void                    poll() override;
+      void                    frame(frame_time t) override;
 
       void                    layout();
       void                    layout(element& element);
+      void                    invalidate_all_limits();
+      std::uint32_t           limits_generation() const { return _limits_generation; }
       float                   scale() const;
       void                    scale(float val);
 
+      // refresh() and refresh(rect) may be called from any thread. Called
+      // from the thread that created the view (the main thread), they take
+      // effect immediately. From other threads, they are posted without
+      // locking or allocating (see notify). The element refreshes must be
+      // called from the main thread.
       void                    refresh() override;
       void                    refresh(rect area) override;
       void                    refresh(element& element, int outward = 0);
       void                    refresh(context const& ctx, int outward = 0);
       rect                    dirty() const;
+      region const&           dirty_region() const { return _dirty; }
+
+      elements::frame_clock&  frame_clock()        { return _frame_clock; }
+      elements::animator&     animator()           { return _animator; }
 
       struct undo_redo_task
       {
@@ -91,15 +111,61 @@ namespace cycfi { namespace elements
       using change_limits_function = std::function<void(view_limits limits_)>;
       change_limits_function on_change_limits;
 
-      using io_context = asio::io_context;
+      // The app scheduler's io_context, shared by all views. Tasks and
+      // timers should be posted through post, which wakes the main loop
+      // and discards them when the view is destroyed. Work submitted
+      // through io() (e.g. io().post(f) or asio timers) runs on the main
+      // thread: io() wakes the main loop, which keeps polling the
+      // io_context for as long as it has work.
+      using io_context = scheduler::io_context;
       io_context&             io();
 
+      // post(duration, f) runs f after the duration. post_tick(period, f)
+      // runs f at the next tick of the app-wide clock with the given period
+      // (e.g. for caret blinks and animation frames), together with all
+      // the other tasks posted for the same period. Both return an id that
+      // can be used to cancel the timer.
+      using timer_id = scheduler::timer_id;
+
                               template <typename T, typename F>
-      void                    post(T duration, F f);
+      timer_id                post(T duration, F f);
+
+                              template <typename T, typename F>
+      timer_id                post_tick(T period, F f);
 
                               template <typename F>
       void                    post(F f);
 
+      // post(p, f) posts f with priority p (input, layout, paint or
+      // normal). Tasks posted with post(f) have normal priority. on_idle(f)
+      // calls f at idle time, within each frame's idle budget, for as long
+      // as f returns true (see scheduler).
+      using priority = scheduler::priority;
+
+                              template <typename F>
+      void                    post(priority p, F f);
+
+                              template <typename F>
+      void                    on_idle(F f);
+
+      // notify(key, f) posts f from any thread without locking or
+      // allocating (e.g. from a real-time audio thread). f must be
+      // trivially copyable, and no larger than
+      // scheduler::notification::max_size. Of the pending notifications
+      // with the same (non-null) key, only the last one runs. Returns false
+      // if the view's notification queue is full.
+                              template <typename F>
+      bool                    notify(void const* key, F f);
+
+      void                    cancel(timer_id& id);
+
+      using clock_type = std::chrono::steady_clock;
+      using time_point = clock_type::time_point;
+
+      time_point              now() const;
+      void                    manual_clock(bool enable);
+      void                    advance_clock(clock_type::duration d);
+
       using tracking = element::tracking;
 
       using track_function = std::function<void(element& e, tracking state)>;
@@ -107,6 +173,20 @@ namespace cycfi { namespace elements
 
       void                    manage_on_tracking(element& e, tracking state);
 
+      void                    track_cursor_path(context const& ctx);
+      bool                    on_cursor_path(element const& parent, element const& child) const;
+
+      // A step of the path to the element being refreshed by
+      // refresh(element&): child is at index in parent
+      struct path_step
+      {
+         element const*       parent;
+         element const*       child;
+         std::size_t          index;
+      };
+
+      path_step const*        on_refresh_path(element const* parent) const;
+
    private:
 
       scaled_content          make_scaled_content() { return elements::scale(1.0, link(_content)); }
@@ -115,8 +195,21 @@ namespace cycfi { namespace elements
       scaled_content          _main_element;
 
       void                    set_limits();
-
-      rect                    _dirty;
+      void                    incremental_layout();
+      void                    relayout_content();
+      bool                    validate_cursor_path(context const& ctx, point p);
+      bool                    find_refresh_path(element const& e);
+      bool                    invalidate_layout_path(element& e);
+      void                    check_tracking();
+      void                    schedule_frame();
+      void                    batch_refresh();
+      void                    batch_refresh(rect area);
+
+      using duration = scheduler::duration;
+      timer_id                post_timer(duration d, bool aligned, std::function<void()> f);
+
+      region                  _dirty;
+      std::uint32_t           _limits_generation = new_limits_generation();
       rect                    _current_bounds;
       view_limits             _current_limits = { { 0, 0 }, { full_extent, full_extent} };
       mouse_button            _current_button;
@@ -126,13 +219,34 @@ namespace cycfi { namespace elements
       undo_stack_type         _undo_stack;
       undo_stack_type         _redo_stack;
 
-      io_context              _io;
-      io_context::work        _work;
+      scheduler::task_queue_ptr _tasks;
 
-      using time_point = std::chrono::steady_clock::time_point;
       element*                _tracking_element = nullptr;
       tracking                _tracking_state = tracking::none;
       time_point              _tracking_time;
+
+      std::vector<element*>   _cursor_path;
+      std::uint32_t           _cursor_path_epoch = 0;
+      bool                    _cursor_path_valid = false;
+      mutable std::size_t     _cursor_path_next = 0;
+
+      std::vector<path_step>  _refresh_path;
+      mutable std::size_t     _refresh_path_next = 0;
+
+      using manual_timer = std::pair<std::uint64_t, std::function<void()>>;
+      using timer_map = std::multimap<time_point, manual_timer>;
+      bool                    _manual_clock = false;
+      time_point              _manual_now;
+      timer_map               _manual_timers;
+      std::uint64_t           _next_manual_timer_id = 1;
+
+      elements::frame_clock   _frame_clock;
+      bool                    _frame_scheduled = false;
+      bool                    _refresh_all = false;
+      region                  _pending_refresh;
+      std::thread::id         _ui_thread;
+      std::atomic<bool>       _refresh_pending{ false };
+      elements::animator      _animator{ *this };
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -151,7 +265,7 @@ namespace cycfi { namespace elements
 
    inline rect view::dirty() const
    {
-      return _dirty;
+      return _dirty.bounds();
    }
 
    inline bool view::has_undo()
@@ -178,6 +292,7 @@ namespace cycfi { namespace elements
    {
       _content = list;
       std::reverse(_content.begin(), _content.end());
+      invalidate_all_limits();
       set_limits();
    }
 
@@ -201,6 +316,7 @@ namespace cycfi { namespace elements
    {
       _content = { detail::add_element(std::forward<E>(elements))... };
       std::reverse(_content.begin(), _content.end());
+      invalidate_all_limits();
       set_limits();
    }
 
@@ -214,7 +330,7 @@ namespace cycfi { namespace elements
             || std::find(_content.begin(), _content.end(), e) != _content.end())
             return;
 
-         io().post(
+         post(scheduler::layout,
             [e, this]
             {
                end_focus();
@@ -234,7 +350,7 @@ namespace cycfi { namespace elements
       // post a function that is called at idle time.
       if (e)
       {
-         io().post(
+         post(scheduler::layout,
             [e, this]
             {
                auto i = std::find(_content.begin(), _content.end(), e);
@@ -244,7 +360,7 @@ namespace cycfi { namespace elements
                   refresh(*e);
                   _content.erase(i);
                   _content.reset();
-                  layout();
+                  relayout_content();
                   begin_focus();
                }
             }
@@ -265,7 +381,7 @@ namespace cycfi { namespace elements
 
    inline view::io_context& view::io()
    {
-      return _io;
+      return app_scheduler().io();
    }
 
    inline mouse_button view::current_button() const
@@ -274,23 +390,39 @@ namespace cycfi { namespace elements
    }
 
    template <typename T, typename F>
-   inline void view::post(T duration, F f)
+   inline view::timer_id view::post(T duration, F f)
    {
-      auto timer = std::make_shared<asio::steady_timer>(_io);
-      timer->expires_from_now(duration);
-      timer->async_wait(
-         [timer, f](auto const& err)
-         {
-            if (!err)
-               f();
-         }
-      );
+      return post_timer(std::chrono::ceil<scheduler::duration>(duration), false, f);
+   }
+
+   template <typename T, typename F>
+   inline view::timer_id view::post_tick(T period, F f)
+   {
+      return post_timer(std::chrono::ceil<scheduler::duration>(period), true, f);
    }
 
    template <typename F>
    inline void view::post(F f)
    {
-      _io.post(f);
+      _tasks->post(f);
+   }
+
+   template <typename F>
+   inline void view::post(priority p, F f)
+   {
+      _tasks->post(f, p);
+   }
+
+   template <typename F>
+   inline void view::on_idle(F f)
+   {
+      _tasks->post_idle(f);
+   }
+
+   template <typename F>
+   inline bool view::notify(void const* key, F f)
+   {
+      return _tasks->notify(key, f);
    }
 }}
 
@@ -0,0 +1,221 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/animation.hpp>
+#include <elements/view.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Easing curves
+   ////////////////////////////////////////////////////////////////////////////
+   namespace easing
+   {
+      float linear(float t)
+      {
+         return t;
+      }
+
+      float ease_in(float t)
+      {
+         return t * t * t;
+      }
+
+      float ease_out(float t)
+      {
+         auto u = 1.0f - t;
+         return 1.0f - u * u * u;
+      }
+
+      float ease_in_out(float t)
+      {
+         if (t < 0.5f)
+            return 4.0f * t * t * t;
+         auto u = -2.0f * t + 2.0f;
+         return 1.0f - (u * u * u) / 2.0f;
+      }
+
+      float ease_out_back(float t)
+      {
+         constexpr float c1 = 1.70158f;
+         constexpr float c3 = c1 + 1.0f;
+         auto u = t - 1.0f;
+         return 1.0f + c3 * u * u * u + c1 * u * u;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // tween
+   ////////////////////////////////////////////////////////////////////////////
+   void tween::set_target(element* e)
+   {
+      target = e? e->weak_handle() : std::weak_ptr<element*>{};
+      has_target = e != nullptr;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // timeline
+   ////////////////////////////////////////////////////////////////////////////
+   timeline& timeline::add(tween t, duration at)
+   {
+      t.delay += at;
+      _length = std::max(_length, t.delay + t.length);
+      _tweens.push_back(std::move(t));
+      return *this;
+   }
+
+   timeline& timeline::then(tween t)
+   {
+      return add(std::move(t), _length);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // animator
+   ////////////////////////////////////////////////////////////////////////////
+   animator::animator(view& view_)
+    : _view(view_)
+   {}
+
+   animator::~animator()
+   {
+      if (_subscription)
+         _view.frame_clock().remove(_subscription);
+   }
+
+   animator::id_type animator::play(tween t)
+   {
+      auto id = _next_id++;
+      _tracks.push_back({ id, std::move(t), {}, false });
+      subscribe();
+      return id;
+   }
+
+   animator::id_type animator::play(timeline t)
+   {
+      // The timeline's tweens share the same id
+      auto id = _next_id++;
+      for (auto& tw : t.tweens())
+         _tracks.push_back({ id, std::move(tw), {}, false });
+      subscribe();
+      return id;
+   }
+
+   void animator::stop(id_type id, bool finish)
+   {
+      // Tracks stopped while stepping are stopped after the frame
+      if (_in_frame)
+      {
+         _stops.emplace_back(id, finish);
+         return;
+      }
+
+      // Move the stopped tracks out first: on_done may play or stop
+      // other tweens
+      track_list stopped;
+      auto i = std::stable_partition(_tracks.begin(), _tracks.end(),
+         [id](auto const& t) { return t.id != id; });
+      std::move(i, _tracks.end(), std::back_inserter(stopped));
+      _tracks.erase(i, _tracks.end());
+
+      for (auto& t : stopped)
+      {
+         if (t.tween_.has_target && t.tween_.target.expired())
+            continue; // the target was destroyed
+         if (finish)
+            step(t, 1.0f);
+         if (t.tween_.on_done)
+            t.tween_.on_done();
+      }
+   }
+
+   void animator::subscribe()
+   {
+      if (!_subscription)
+         _subscription = _view.frame_clock().add(
+            [this](time_point t) { return frame(t); }
+         );
+   }
+
+   bool animator::step(track& t, float progress)
+   {
+      // Note: apply may play new tweens, invalidating t
+      auto& tw = t.tween_;
+      auto target = tw.target;
+      bool has_target = tw.has_target;
+      if (has_target && target.expired())
+         return false;
+      if (tw.apply)
+         tw.apply(tw.easing? tw.easing(progress) : progress);
+
+      // Refresh only the target element, if there is one
+      if (!has_target)
+         _view.refresh();
+      else if (auto e = target.lock())
+         _view.refresh(**e);
+      return true;
+   }
+
+   bool animator::frame(time_point now)
+   {
+      // Step all the tracks, then finish the ones that are done. Tracks
+      // started in this frame start from this frame's time.
+      track_list done;
+      _in_frame = true;
+      for (std::size_t i = 0; i != _tracks.size();)
+      {
+         auto& t = _tracks[i];
+         if (!t.started)
+         {
+            t.start = now;
+            t.started = true;
+         }
+
+         auto elapsed = now - t.start - t.tween_.delay;
+         if (elapsed < tween::duration::zero())
+         {
+            ++i;
+            continue;
+         }
+
+         auto length = t.tween_.length;
+         float progress = (length.count() > 0)?
+            std::min(float(elapsed.count()) / length.count(), 1.0f) : 1.0f;
+         if (!step(t, progress))
+         {
+            // The target was destroyed
+            _tracks.erase(_tracks.begin() + i);
+         }
+         else if (progress >= 1.0f)
+         {
+            done.push_back(std::move(_tracks[i]));
+            _tracks.erase(_tracks.begin() + i);
+         }
+         else
+         {
+            ++i;
+         }
+      }
+
+      _in_frame = false;
+
+      for (auto& t : done)
+         if (t.tween_.on_done)
+            t.tween_.on_done();
+
+      stop_list stops;
+      std::swap(stops, _stops);
+      for (auto [id, finish] : stops)
+         stop(id, finish);
+
+      // Keep the subscription only while there is something to play
+      if (_tracks.empty())
+      {
+         _subscription = 0;
+         return false;
+      }
+      return true;
+   }
+}}
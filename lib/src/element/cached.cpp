@@ -0,0 +1,90 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/cached.hpp>
+#include <elements/support/context.hpp>
+#include <elements/support/canvas.hpp>
+#include <elements/view.hpp>
+#include <cairo.h>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   void cached_element::layout(context const& ctx)
+   {
+      _valid = false;
+      proxy_base::layout(ctx);
+   }
+
+   void cached_element::draw(context const& ctx)
+   {
+      auto& cr = ctx.canvas.cairo_context();
+      cairo_matrix_t m;
+      cairo_get_matrix(&cr, &m);
+
+      // Compute the bounds in device pixels, snapped to whole pixels
+      double x1 = ctx.bounds.left, y1 = ctx.bounds.top;
+      double x2 = ctx.bounds.right, y2 = ctx.bounds.bottom;
+      cairo_user_to_device(&cr, &x1, &y1);
+      cairo_user_to_device(&cr, &x2, &y2);
+      rect device_bounds = {
+         float(std::floor(std::min(x1, x2))), float(std::floor(std::min(y1, y2)))
+       , float(std::ceil(std::max(x1, x2))), float(std::ceil(std::max(y1, y2)))
+      };
+      if (device_bounds.width() <= 0 || device_bounds.height() <= 0)
+         return;
+
+      point device_scale = { float(m.xx), float(m.yy) };
+      if (!_pixmap
+         || !_valid
+         || _bounds != ctx.bounds
+         || _device_bounds != device_bounds
+         || _device_scale != device_scale)
+      {
+         // Refreshes requested while the subject draws invalidate the
+         // cache again for the next paint
+         _valid = true;
+
+         point size = { device_bounds.width(), device_bounds.height() };
+         if (!_pixmap
+            || _pixmap->size().width != size.x
+            || _pixmap->size().height != size.y)
+         {
+            _pixmap = std::make_unique<pixmap>(size);
+         }
+         else
+         {
+            pixmap_context pmctx{ *_pixmap };
+            cairo_set_operator(pmctx.context(), CAIRO_OPERATOR_CLEAR);
+            cairo_paint(pmctx.context());
+         }
+
+         {
+            // Draw the subject with the same transform as the view, offset
+            // to the pixmap's origin
+            pixmap_context pmctx{ *_pixmap };
+            canvas pm_cnv{ *pmctx.context() };
+            pm_cnv.pre_scale(ctx.canvas.pre_scale());
+            m.x0 -= device_bounds.left;
+            m.y0 -= device_bounds.top;
+            cairo_set_matrix(pmctx.context(), &m);
+
+            context pm_ctx{ ctx.view, pm_cnv, ctx.element, ctx.bounds };
+            pm_ctx.parent = ctx.parent;
+            proxy_base::draw(pm_ctx);
+         }
+
+         _bounds = ctx.bounds;
+         _device_bounds = device_bounds;
+         _device_scale = device_scale;
+      }
+
+      // Blit the pixmap, one pixmap pixel per device pixel
+      cairo_save(&cr);
+      cairo_identity_matrix(&cr);
+      ctx.canvas.draw(*_pixmap, device_bounds.left_top());
+      cairo_restore(&cr);
+   }
+}}
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/element/composite.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/trace.hpp>
 #include <elements/view.hpp>
 
 namespace cycfi { namespace elements
@@ -24,12 +25,23 @@ namespace cycfi { namespace elements
 
    void composite_base::draw(context const& ctx)
    {
+      // Draw only the elements in the damaged region, including what they
+      // may draw outside their bounds (see canvas::overdraw_margin). The
+      // damage (or the view bounds, if there is no damage) is found in
+      // user coordinates once, not once per element.
+      auto const* damage = ctx.canvas.user_damage();
+      auto view_bounds = ctx.view_bounds();
+      constexpr auto margin = canvas::overdraw_margin;
+
       for (std::size_t ix = 0; ix < size(); ++ix)
       {
-         if (auto bounds = bounds_of(ctx, ix); bounds.is_intersects(ctx.view_bounds()))
+         auto bounds = bounds_of(ctx, ix);
+         auto paint_bounds = bounds.inset(-margin, -margin);
+         if (damage? damage->intersects(paint_bounds) : paint_bounds.is_intersects(view_bounds))
          {
             auto& e = at(ix);
             context ectx{ ctx, &e, bounds };
+            trace_zone zone{ typeid(e), "draw" };
             e.draw(ectx);
          }
       }
@@ -41,6 +53,15 @@ namespace cycfi { namespace elements
       {
          ctx.view.refresh(ctx, outward);
       }
+      else if (auto step = ctx.view.on_refresh_path(ctx.element);
+         step && step->index < size() && &at(step->index) == step->child)
+      {
+         // Descend only into the child containing the element
+         rect bounds = bounds_of(ctx, step->index);
+         auto& e = at(step->index);
+         context ectx{ ctx, &e, bounds };
+         e.refresh(ectx, element, outward);
+      }
       else
       {
          for (std::size_t ix = 0; ix < size(); ++ix)
@@ -220,6 +241,21 @@ namespace cycfi { namespace elements
          return false;
       }
 
+      // If the view found that the cursor is still on the same path as
+      // the last cursor event, skip the hit tests and send hovering to the
+      // current tracking element.
+      if (status == cursor_tracking::hovering
+         && _cursor_tracking != -1
+         && _cursor_hovering.size() == 1
+         && *_cursor_hovering.begin() == _cursor_tracking
+         && ctx.element
+         && ctx.view.on_cursor_path(*ctx.element, at(_cursor_tracking)))
+      {
+         auto& e = at(_cursor_tracking);
+         context ectx{ ctx, &e, bounds_of(ctx, _cursor_tracking) };
+         return e.cursor(ectx, p, status);
+      }
+
       // Send cursor leaving to all currently hovering elements if p is
       // outside the elements's bounds or if the element is no longer hit.
       for (auto i = _cursor_hovering.begin(); i != _cursor_hovering.end();)
@@ -253,6 +289,7 @@ namespace cycfi { namespace elements
          }
          auto& e = at(_cursor_tracking);
          context ectx{ ctx, &e, bounds_of(ctx, _cursor_tracking) };
+         ctx.view.track_cursor_path(ectx);
          return e.cursor(ectx, p, status);
       }
 
@@ -324,37 +361,55 @@ namespace cycfi { namespace elements
 
    composite_base::hit_info composite_base::hit_element(context const& ctx, point p, bool control) const
    {
-      auto&& test_element =
-         [&](int ix, hit_info& info) -> bool
+      return hit_range(ctx, p, control, 0, size());
+   }
+
+   bool composite_base::hit_child(
+      context const& ctx, std::size_t index
+    , point p, bool control, hit_info& info
+   ) const
+   {
+      auto& e = at(index);
+      if (!control || e.wants_control())
+      {
+         rect bounds = bounds_of(ctx, index);
+         if (bounds.includes(p))
          {
-            auto& e = at(ix);
-            if (!control || e.wants_control())
+            context ectx{ ctx, &e, bounds };
+            if (e.hit_test(ectx, p))
             {
-               rect bounds = bounds_of(ctx, ix);
-               if (bounds.includes(p))
-               {
-                  context ectx{ ctx, &e, bounds };
-                  if (e.hit_test(ectx, p))
-                  {
-                     info = hit_info{ e.shared_from_this(), bounds, int(ix) };
-                     return true;
-                  }
-               }
+               info = hit_info{ e.shared_from_this(), bounds, int(index) };
+               return true;
             }
-            return false;
-         };
+         }
+      }
+      return false;
+   }
+
+   bool composite_base::hit_preceding(context const& ctx, point p, std::size_t index) const
+   {
+      // Check the elements tested before index by hit_element
+      if (reverse_index())
+         return hit_range(ctx, p, true, index+1, size()).element != nullptr;
+      return hit_range(ctx, p, true, 0, index).element != nullptr;
+   }
 
+   composite_base::hit_info composite_base::hit_range(
+      context const& ctx, point p, bool control
+    , std::size_t first, std::size_t last
+   ) const
+   {
       hit_info info = hit_info{ {}, rect{}, -1 };
       if (reverse_index())
       {
-         for (int ix = int(size())-1; ix >= 0; --ix)
-            if (test_element(ix, info))
+         for (auto ix = last; ix != first; --ix)
+            if (hit_child(ctx, ix-1, p, control, info))
                break;
       }
       else
       {
-         for (std::size_t ix = 0; ix < size(); ++ix)
-            if (test_element(ix, info))
+         for (auto ix = first; ix != last; ++ix)
+            if (hit_child(ctx, ix, p, control, info))
                break;
       }
       return info;
@@ -9,6 +9,18 @@
 
 namespace cycfi { namespace elements
 {
+   namespace
+   {
+      // The last generation handed out to a view. Generations are unique
+      // across views, so that an element laid out in more than one view
+      // never takes the limits cached for one view as valid in another.
+      // Zero is never a valid generation.
+      std::uint32_t generation = 0;
+
+      // Incremented whenever any limits or layout is invalidated
+      std::uint32_t epoch = 1;
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // element class implementation
    ////////////////////////////////////////////////////////////////////////////
@@ -107,4 +119,92 @@ namespace cycfi { namespace elements
    {
       ctx.view.manage_on_tracking(*this, state);
    }
+
+   view_limits element::cached_limits(basic_context const& ctx) const
+   {
+      auto const generation = ctx.view.limits_generation();
+      if (_limits_generation != generation)
+      {
+         _cached_limits = limits(ctx);
+         _limits_generation = generation;
+      }
+      return _cached_limits;
+   }
+
+   void element::update_layout(context const& ctx, std::size_t index)
+   {
+      if (auto parent = ctx.parent? ctx.parent->element : nullptr)
+         _layout_link.parent = parent->weak_handle();
+      else
+         _layout_link.parent.reset();
+      _layout_link.index = index;
+      auto const generation = ctx.view.limits_generation();
+      if (_layout_generation != generation || _layout_bounds != ctx.bounds)
+      {
+         // Update the generation before calling layout, in case the layout
+         // invalidates this element again (e.g. the limits changed).
+         _layout_bounds = ctx.bounds;
+         _layout_generation = generation;
+         layout(ctx);
+      }
+   }
+
+   std::weak_ptr<element*> element::weak_handle()
+   {
+      auto& anchor = _layout_link.anchor;
+      if (!anchor)
+         anchor = std::make_shared<element*>(this);
+      return anchor;
+   }
+
+   element const* element::layout_parent() const
+   {
+      auto anchor = _layout_link.parent.lock();
+      return anchor? *anchor : nullptr;
+   }
+
+   element* element::layout_parent()
+   {
+      auto anchor = _layout_link.parent.lock();
+      return anchor? *anchor : nullptr;
+   }
+
+   void element::invalidate_limits()
+   {
+      _limits_generation = 0;
+      _layout_generation = 0;
+      ++epoch;
+   }
+
+   void element::invalidate_limits(context const& ctx)
+   {
+      invalidate_limits();
+      for (auto p = &ctx; p; p = p->parent)
+      {
+         if (p->element)
+            p->element->invalidate_limits();
+      }
+   }
+
+   void element::invalidate_layout()
+   {
+      _layout_generation = 0;
+      ++epoch;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Limits and layout cache
+   ////////////////////////////////////////////////////////////////////////////
+   std::uint32_t new_limits_generation()
+   {
+      if (++generation == 0)
+         generation = 1;
+      ++epoch;
+      return generation;
+   }
+
+   std::uint32_t layout_epoch()
+   {
+      return epoch;
+   }
 }}
@@ -10,14 +10,14 @@ namespace cycfi { namespace elements
 {
    view_limits floating_element::limits(basic_context const& ctx) const
    {
-      auto e_limits = this->subject().limits(ctx);
+      auto e_limits = this->subject().cached_limits(ctx);
       return { { e_limits.min.x, e_limits.min.y }, { full_extent, full_extent } };
    }
 
    void floating_element::prepare_subject(context& ctx)
    {
       ctx.bounds = this->bounds();
-      auto  e_limits = this->subject().limits(ctx);
+      auto  e_limits = this->subject().cached_limits(ctx);
       float w = ctx.bounds.width();
       float h = ctx.bounds.height();
 
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/element/flow.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/trace.hpp>
 #include <elements/view.hpp>
 
 namespace cycfi { namespace elements
@@ -21,7 +22,7 @@ namespace cycfi { namespace elements
 
          for (std::size_t i = 0; i != _flowable.size();  ++i)
          {
-            auto el = _flowable.at(i).limits(ctx);
+            auto el = _flowable.at(i).cached_limits(ctx);
             clamp_min(limits_.min.x, el.min.x);
          }
       }
@@ -30,13 +31,26 @@ namespace cycfi { namespace elements
 
    void flow_element::layout(context const& ctx)
    {
+      auto const prev_height = base_type::limits(ctx).min.y;
       clear();
       _flowable.break_lines(*this, ctx, ctx.bounds.width());
+
+      // Our limits change if the rows' height changed
+      if (base_type::limits(ctx).min.y != prev_height)
+         invalidate_limits(ctx);
       base_type::layout(ctx);
 
       if (_flowable.needs_reflow())
       {
-         ctx.view.post([&view = ctx.view]{ view.layout(); });
+         // Relayout only this element and its ancestors. view::layout
+         // refreshes our bounds. Skip it if we are gone by then.
+         ctx.view.post(scheduler::layout,
+            [&view = ctx.view, handle = weak_handle()]
+            {
+               if (auto self = handle.lock())
+                  view.layout(**self);
+            }
+         );
          _flowable.reflow_done();
       }
    }
@@ -47,6 +61,7 @@ namespace cycfi { namespace elements
     , float width
    )
    {
+      trace_zone zone{ "flowable_container::break_lines", "layout" };
       double      curr_x = 0;
       std::size_t first = 0;
       std::size_t last = 0;
@@ -72,7 +87,7 @@ namespace cycfi { namespace elements
 
    float flowable_container::width_of(size_t index, basic_context const& ctx) const
    {
-      return at(index).limits(ctx).min.x;
+      return at(index).cached_limits(ctx).min.x;
    }
 
    element_ptr flowable_container::make_row(size_t first, size_t last)
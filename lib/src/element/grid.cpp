@@ -6,8 +6,26 @@
 #include <elements/element/grid.hpp>
 #include <elements/support/context.hpp>
 
+#include <algorithm>
+
 namespace cycfi { namespace elements
 {
+   namespace
+   {
+      // Find the grid cell that includes pos. Cell i spans the half-open
+      // interval [positions[i], positions[i+1]), exactly as bounds_of and
+      // rect::includes see it: a point on an edge shared by two cells is
+      // in the later one. Returns -1 if pos is outside the grid, including
+      // on its far edge.
+      int find_cell(std::vector<float> const& positions, float pos)
+      {
+         auto i = std::upper_bound(positions.begin(), positions.end(), pos);
+         if (i == positions.begin() || i == positions.end())
+            return -1;
+         return int(i - positions.begin()) - 1;
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Vertical Grids
    ////////////////////////////////////////////////////////////////////////////
@@ -16,7 +34,7 @@ namespace cycfi { namespace elements
       view_limits limits{ { 0.0, 0.0 }, { full_extent, 0.0 } };
       for (std::size_t i = 0; i != size();  ++i)
       {
-         auto el = at(i).limits(ctx);
+         auto el = at(i).cached_limits(ctx);
 
          limits.min.y += el.min.y;
          limits.max.y += el.max.y;
@@ -51,7 +69,7 @@ namespace cycfi { namespace elements
          auto y = grid_coord(gi++) * total_height;
          auto height = y - prev;
          rect ebounds = { left, prev+top, right, prev+top+height };
-         elem.layout(context{ ctx, &elem, ebounds });
+         elem.update_layout(context{ ctx, &elem, ebounds }, i);
          _positions[i] = prev+top;
          prev = y;
       }
@@ -67,6 +85,14 @@ namespace cycfi { namespace elements
       return { left, _positions[index], right, _positions[index+1] };
    }
 
+   vgrid_element::hit_info vgrid_element::hit_element(context const& ctx, point p, bool control) const
+   {
+      auto ix = find_cell(_positions, p.y);
+      if (ix < 0 || std::size_t(ix) >= size())
+         return hit_info{ {}, rect{}, -1 };
+      return hit_range(ctx, p, control, ix, ix+1);
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Horizontal Grids
    ////////////////////////////////////////////////////////////////////////////
@@ -75,7 +101,7 @@ namespace cycfi { namespace elements
       view_limits limits{ { 0.0, 0.0 }, { 0.0, full_extent } };
       for (std::size_t i = 0; i != size();  ++i)
       {
-         auto el = at(i).limits(ctx);
+         auto el = at(i).cached_limits(ctx);
 
          limits.min.x += el.min.x;
          limits.max.x += el.max.x;
@@ -110,7 +136,7 @@ namespace cycfi { namespace elements
          auto x = grid_coord(gi++) * total_width;
          auto width = x - prev;
          rect ebounds = { prev+left, top, prev+left+width, bottom };
-         elem.layout(context{ ctx, &elem, ebounds });
+         elem.update_layout(context{ ctx, &elem, ebounds }, i);
          _positions[i] = prev+left;
          prev = x;
       }
@@ -125,4 +151,12 @@ namespace cycfi { namespace elements
       auto bottom = ctx.bounds.bottom;
       return { _positions[index], top, _positions[index+1], bottom };
    }
+
+   hgrid_element::hit_info hgrid_element::hit_element(context const& ctx, point p, bool control) const
+   {
+      auto ix = find_cell(_positions, p.x);
+      if (ix < 0 || std::size_t(ix) >= size())
+         return hit_info{ {}, rect{}, -1 };
+      return hit_range(ctx, p, control, ix, ix+1);
+   }
 }}
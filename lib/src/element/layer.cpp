@@ -4,11 +4,32 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/element/layer.hpp>
+#include <elements/element/floating.hpp>
 #include <elements/view.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/trace.hpp>
+
+#include <cmath>
 
 namespace cycfi { namespace elements
 {
+   namespace
+   {
+      // Layers with fewer elements than this are hit tested linearly
+      constexpr std::size_t hit_index_threshold = 16;
+      constexpr std::size_t max_hit_index_cells = 32;
+
+      std::size_t find_cell(float pos, float origin, float extent, std::size_t cells)
+      {
+         auto c = (pos - origin) * cells / extent;
+         if (!(c > 0))
+            return 0;
+         if (c >= cells)
+            return cells-1;
+         return std::size_t(c);
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Layer
    ////////////////////////////////////////////////////////////////////////////
@@ -17,7 +38,7 @@ namespace cycfi { namespace elements
       view_limits limits{ { 0.0, 0.0 }, { full_extent, full_extent } };
       for (std::size_t ix = 0; ix != size();  ++ix)
       {
-         auto el = at(ix).limits(ctx);
+         auto el = at(ix).cached_limits(ctx);
 
          clamp_min(limits.min.x, el.min.x);
          clamp_min(limits.min.y, el.min.y);
@@ -33,10 +54,11 @@ namespace cycfi { namespace elements
 
    void layer_element::layout(context const& ctx)
    {
+      _hit_index.epoch = 0;
       for (std::size_t ix = 0; ix != size(); ++ix)
       {
          auto& e = at(ix);
-         e.layout(context{ ctx, &e, bounds_of(ctx, ix) });
+         e.update_layout(context{ ctx, &e, bounds_of(ctx, ix) }, ix);
       }
    }
 
@@ -55,22 +77,95 @@ namespace cycfi { namespace elements
 
    layer_element::hit_info layer_element::hit_element(context const& ctx, point p, bool control) const
    {
-      // we test from the highest index (topmost element)
-      for (int ix = int(size())-1; ix >= 0; --ix)
+      hit_info info = hit_info{ {}, rect{}, -1 };
+      if (auto bucket = hit_bucket(ctx, p))
+      {
+         // we test from the highest index (topmost element)
+         for (auto i = bucket->rbegin(); i != bucket->rend(); ++i)
+            if (hit_child(ctx, *i, p, control, info))
+               break;
+      }
+      else
+      {
+         // we test from the highest index (topmost element)
+         for (int ix = int(size())-1; ix >= 0; --ix)
+            if (hit_child(ctx, ix, p, control, info))
+               break;
+      }
+      return info;
+   }
+
+   bool layer_element::hit_preceding(context const& ctx, point p, std::size_t index) const
+   {
+      // Check the elements above index, using the hit index if there is one
+      if (auto bucket = hit_bucket(ctx, p))
+      {
+         hit_info info = hit_info{ {}, rect{}, -1 };
+         for (auto i = bucket->rbegin(); i != bucket->rend() && std::size_t(*i) > index; ++i)
+            if (hit_child(ctx, *i, p, true, info))
+               return true;
+         return false;
+      }
+      return composite_base::hit_preceding(ctx, p, index);
+   }
+
+   layer_element::bucket_type const*
+   layer_element::hit_bucket(context const& ctx, point p) const
+   {
+      // Returns the bucket of the hit index containing p, or nullptr if the
+      // layer is too small to be worth indexing.
+      if (size() < hit_index_threshold || ctx.bounds.width() <= 0 || ctx.bounds.height() <= 0)
+         return nullptr;
+
+      update_hit_index(ctx);
+      auto& bounds = _hit_index.bounds;
+      auto col = find_cell(p.x, bounds.left, bounds.width(), _hit_index.columns);
+      auto row = find_cell(p.y, bounds.top, bounds.height(), _hit_index.rows);
+      return &_hit_index.buckets[row * _hit_index.columns + col];
+   }
+
+   void layer_element::update_hit_index(context const& ctx) const
+   {
+      auto const sz = size();
+      if (_hit_index.epoch == layout_epoch()
+         && _hit_index.size == sz
+         && _hit_index.bounds == ctx.bounds)
+         return;
+
+      auto const cells = std::min(
+         std::size_t(std::ceil(std::sqrt(float(sz)))), max_hit_index_cells);
+      auto& bounds = _hit_index.bounds;
+      bounds = ctx.bounds;
+      _hit_index.epoch = layout_epoch();
+      _hit_index.size = sz;
+      _hit_index.columns = cells;
+      _hit_index.rows = cells;
+      _hit_index.buckets.resize(cells * cells);
+      for (auto& bucket : _hit_index.buckets)
+         bucket.clear();
+
+      for (std::size_t ix = 0; ix != sz; ++ix)
       {
          auto& e = at(ix);
-         if (!control || e.wants_control())
+         rect r = bounds_of(ctx, ix);
+
+         // Floating elements are hit only within their own bounds
+         if (auto f = dynamic_cast<floating_element*>(&e))
          {
-            rect bounds = bounds_of(ctx, ix);
-            if (bounds.includes(p))
-            {
-               context ectx{ ctx, &e, bounds };
-               if (e.hit_test(ectx, p))
-                  return hit_info{ e.shared_from_this(), bounds, int(ix) };
-            }
+            context fctx{ ctx, &e, r };
+            f->prepare_subject(fctx);
+            r = fctx.bounds;
+            f->restore_subject(fctx);
          }
+
+         auto col1 = find_cell(r.left, bounds.left, bounds.width(), cells);
+         auto col2 = find_cell(r.right, bounds.left, bounds.width(), cells);
+         auto row1 = find_cell(r.top, bounds.top, bounds.height(), cells);
+         auto row2 = find_cell(r.bottom, bounds.top, bounds.height(), cells);
+         for (auto row = row1; row <= row2; ++row)
+            for (auto col = col1; col <= col2; ++col)
+               _hit_index.buckets[row * cells + col].push_back(int(ix));
       }
-      return hit_info{ {}, rect{}, -1 };
    }
 
    rect layer_element::bounds_of(context const& ctx, std::size_t index) const
@@ -79,7 +174,7 @@ namespace cycfi { namespace elements
       auto top = ctx.bounds.top;
       auto width = ctx.bounds.width();
       auto height = ctx.bounds.height();
-      auto  limits = at(index).limits(ctx);
+      auto  limits = at(index).cached_limits(ctx);
 
       clamp_min(width, limits.min.x);
       clamp_max(width, limits.max.x);
@@ -117,10 +212,12 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    void deck_element::draw(context const& ctx)
    {
-      if (auto bounds = bounds_of(ctx, _selected_index); bounds.is_intersects(ctx.view_bounds()))
+      auto bounds = bounds_of(ctx, _selected_index);
+      if (bounds.is_intersects(ctx.view_bounds()) && ctx.canvas.is_damaged(bounds))
       {
          auto& elem = at(_selected_index);
          context ectx{ ctx, &elem, bounds };
+         trace_zone zone{ typeid(elem), "draw" };
          elem.draw(ectx);
       }
    }
@@ -169,7 +266,13 @@ namespace cycfi { namespace elements
 
    void deck_element::select(std::size_t index)
    {
-      if (index < size())
+      if (index < size() && index != _selected_index)
+      {
          _selected_index = index;
+
+         // Only the selected element is hit and drawn: discard the
+         // cursor path and other data derived from the layout.
+         invalidate_layout();
+      }
    }
 }}
@@ -13,7 +13,7 @@ namespace cycfi { namespace elements
 {
    void basic_menu::layout_menu(context const& ctx)
    {
-      auto pu_limits = _popup->limits(ctx);
+      auto pu_limits = _popup->cached_limits(ctx);
       rect  bounds;
 
       switch (_position)
@@ -5,9 +5,11 @@
 =============================================================================*/
 #include <elements/element/port.hpp>
 #include <elements/element/traversal.hpp>
+#include <elements/support/lru_cache.hpp>
 #include <elements/view.hpp>
 #include <algorithm>
 #include <cmath>
+#include <tuple>
 
 namespace cycfi { namespace elements
 {
@@ -29,13 +31,13 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits port_element::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = subject().cached_limits(ctx);
       return {{ min_port_size, min_port_size }, e_limits.max };
    }
 
    void port_element::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
+      view_limits    e_limits          = subject().cached_limits(ctx);
       double         elem_width        = e_limits.min.x;
       double         elem_height       = e_limits.min.y;
       double         available_width   = ctx.parent->bounds.width();
@@ -46,7 +48,7 @@ namespace cycfi { namespace elements
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.heighten(elem_height);
 
-      subject().layout(ctx);
+      subject().update_layout(ctx);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -54,20 +56,20 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits vport_element::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = subject().cached_limits(ctx);
       return {{ e_limits.min.x, min_port_size }, e_limits.max };
    }
 
    void vport_element::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
+      view_limits    e_limits          = subject().cached_limits(ctx);
       double         elem_height       = e_limits.min.y;
       double         available_height  = ctx.parent->bounds.height();
 
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.heighten(elem_height);
 
-      subject().layout(ctx);
+      subject().update_layout(ctx);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -75,20 +77,20 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits hport_element::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = subject().cached_limits(ctx);
       return {{ min_port_size, e_limits.min.y }, e_limits.max };
    }
 
    void hport_element::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
+      view_limits    e_limits          = subject().cached_limits(ctx);
       double         elem_width        = e_limits.min.x;
       double         available_width   = ctx.parent->bounds.width();
 
       ctx.bounds.left -= (elem_width - available_width) * _halign;
       ctx.bounds.widen(elem_width);
 
-      subject().layout(ctx);
+      subject().update_layout(ctx);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -123,6 +125,24 @@ namespace cycfi { namespace elements
          _canvas.fill();
       }
 
+      // The scrollbar thumb's shape, at the origin. Thumbs of the same
+      // size share the same path.
+      canvas::path const& get_scrollbar_path(float width, float height, float radius)
+      {
+         using key_type = std::tuple<float, float, float>;
+         constexpr std::size_t max_cached_paths = 64;
+         static lru_cache<key_type, canvas::path> cache{ max_cached_paths };
+
+         return cache.get({ width, height, radius },
+            [=]
+            {
+               return canvas::make_path(
+                  [=](canvas& cnv) { cnv.round_rect({ 0, 0, width, height }, radius); }
+               );
+            }
+         );
+      }
+
       void draw_scrollbar(
          canvas& _canvas, rect b, float radius,
          color outline_color, color fill_color, point mp,
@@ -130,7 +150,7 @@ namespace cycfi { namespace elements
       )
       {
          _canvas.begin_path();
-         _canvas.round_rect(b, radius);
+         _canvas.add_path(get_scrollbar_path(b.width(), b.height(), radius), b.left_top());
          _canvas.fill_style(fill_color);
 
          if (is_tracking || _canvas.hit_test(mp))
@@ -197,7 +217,7 @@ namespace cycfi { namespace elements
 
    view_limits scroller_base::limits(basic_context const& ctx) const
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = subject().cached_limits(ctx);
       return view_limits{
          { allow_hscroll() ? min_port_size : e_limits.min.x, allow_vscroll() ? min_port_size : e_limits.min.y },
          { e_limits.max.x,                                   e_limits.max.y }
@@ -206,7 +226,7 @@ namespace cycfi { namespace elements
 
    void scroller_base::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
+      view_limits    e_limits          = subject().cached_limits(ctx);
 
       if (allow_vscroll())
       {
@@ -225,7 +245,7 @@ namespace cycfi { namespace elements
          ctx.bounds.left -= (elem_width - available_width) * halign();
          ctx.bounds.widen(elem_width);
       }
-      subject().layout(ctx);
+      subject().update_layout(ctx);
    }
 
    element* scroller_base::hit_test(context const& ctx, point p)
@@ -237,7 +257,7 @@ namespace cycfi { namespace elements
    scroller_base::get_scrollbar_bounds(context const& ctx)
    {
       scrollbar_bounds r;
-      view_limits      e_limits = subject().limits(ctx);
+      view_limits      e_limits = subject().cached_limits(ctx);
 
       r.has_h = e_limits.min.x > ctx.bounds.width() && allow_hscroll();
       r.has_v = e_limits.min.y > ctx.bounds.height() && allow_vscroll();
@@ -279,7 +299,7 @@ namespace cycfi { namespace elements
       if (has_scrollbars())
       {
          scrollbar_bounds  sb = get_scrollbar_bounds(ctx);
-         view_limits       e_limits = subject().limits(ctx);
+         view_limits       e_limits = subject().cached_limits(ctx);
          point             mp = ctx.cursor_pos();
 
          if (sb.has_v)
@@ -292,7 +312,7 @@ namespace cycfi { namespace elements
 
    bool scroller_base::scroll(context const& ctx, point dir, point /* p */)
    {
-      view_limits e_limits = subject().limits(ctx);
+      view_limits e_limits = subject().cached_limits(ctx);
       bool redraw = false;
 
       if (allow_hscroll())
@@ -353,7 +373,7 @@ namespace cycfi { namespace elements
          return false;
 
       scrollbar_bounds  sb = get_scrollbar_bounds(ctx);
-      view_limits       e_limits = subject().limits(ctx);
+      view_limits       e_limits = subject().cached_limits(ctx);
 
       auto valign_ = [&](double align)
       {
@@ -540,7 +560,7 @@ namespace cycfi { namespace elements
             case key_code::page_up:
             case key_code::page_down:
             {
-               view_limits e_limits = subject().limits(ctx);
+               view_limits e_limits = subject().cached_limits(ctx);
                scrollbar_bounds sb = get_scrollbar_bounds(ctx);
                rect b = scroll_bar_position(
                   ctx, { valign(), e_limits.min.y, sb.vscroll_bounds });
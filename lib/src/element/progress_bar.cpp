@@ -13,8 +13,8 @@ namespace cycfi::elements
 {
    view_limits progress_bar_base::limits(basic_context const& ctx) const
    {
-      auto const fg_limits = foreground().limits(ctx);
-      auto       bg_limits = background().limits(ctx);
+      auto const fg_limits = foreground().cached_limits(ctx);
+      auto       bg_limits = background().cached_limits(ctx);
 
       bg_limits.min.y = std::max(bg_limits.min.y, fg_limits.min.y);
       bg_limits.min.x = std::max(bg_limits.min.x, fg_limits.min.x);
@@ -65,7 +65,7 @@ namespace cycfi::elements
 
    rect progress_bar_base::background_bounds(context const& ctx) const
    {
-      auto const limits_ = background().limits(ctx);
+      auto const limits_ = background().cached_limits(ctx);
       auto bounds = ctx.bounds;
       bounds.heighten(std::min<float>(limits_.max.y, bounds.height()));
       bounds.widen(std::min<float>(limits_.max.x, bounds.width()));
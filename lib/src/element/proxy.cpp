@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/element/proxy.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/trace.hpp>
 #include <elements/view.hpp>
 
 namespace cycfi { namespace elements
@@ -14,7 +15,7 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits proxy_base::limits(basic_context const& ctx) const
    {
-      return subject().limits(ctx);
+      return subject().cached_limits(ctx);
    }
 
    view_stretch proxy_base::stretch() const
@@ -40,7 +41,10 @@ namespace cycfi { namespace elements
    {
       context sctx { ctx, &subject(), ctx.bounds };
       prepare_subject(sctx);
-      subject().draw(sctx);
+      {
+         trace_zone zone{ typeid(subject()), "draw" };
+         subject().draw(sctx);
+      }
       restore_subject(sctx);
    }
 
@@ -48,7 +52,7 @@ namespace cycfi { namespace elements
    {
       context sctx { ctx, &subject(), ctx.bounds };
       prepare_subject(sctx);
-      subject().layout(sctx);
+      subject().update_layout(sctx);
       restore_subject(sctx);
    }
 
@@ -12,8 +12,8 @@ namespace cycfi { namespace elements
 {
    view_limits slider_base::limits(basic_context const& ctx) const
    {
-      auto  limits_ = track().limits(ctx);
-      auto  tmb_limits = thumb().limits(ctx);
+      auto  limits_ = track().cached_limits(ctx);
+      auto  tmb_limits = thumb().cached_limits(ctx);
 
       // We multiply thumb min limits by 2 so that there is always some space to move it.
       if (_is_horiz = limits_.max.x > limits_.max.y; _is_horiz)
@@ -76,7 +76,7 @@ namespace cycfi { namespace elements
 
    rect slider_base::track_bounds(context const& ctx) const
    {
-      auto  limits_ = track().limits(ctx);
+      auto  limits_ = track().cached_limits(ctx);
       auto  bounds = ctx.bounds;
       auto  th_bounds = thumb_bounds(ctx);
 
@@ -104,7 +104,7 @@ namespace cycfi { namespace elements
       auto  bounds = ctx.bounds;
       auto  w = bounds.width();
       auto  h = bounds.height();
-      auto  limits_ = thumb().limits(ctx);
+      auto  limits_ = thumb().cached_limits(ctx);
       auto  tmb_w = limits_.max.x;
       auto  tmb_h = limits_.max.y;
 
@@ -127,7 +127,7 @@ namespace cycfi { namespace elements
       auto  w = bounds.width();
       auto  h = bounds.height();
 
-      auto  limits_ = thumb().limits(ctx);
+      auto  limits_ = thumb().cached_limits(ctx);
       auto  tmb_w = limits_.max.x;
       auto  tmb_h = limits_.max.y;
       auto  new_value = 0.0;
@@ -60,6 +60,9 @@ namespace cycfi { namespace elements
       // Refresh the union of the old and new bounds if the size has changed
       if (_current_size.x != new_x || _current_size.y != new_y)
       {
+         // Our limits depend on the current size
+         invalidate_limits(ctx);
+
          if (_current_size.x != -1 && _current_size.y != -1)
             ctx.view.refresh(ctx.bounds.reconstruct_max_with(rect(ctx.bounds.left_top(), extent{_current_size})));
          else
@@ -107,6 +110,7 @@ namespace cycfi { namespace elements
       _rows.clear();
       _layout.text(_text.data(), _text.data() + _text.size());
       _layout.break_lines(_current_size.x, _rows);
+      invalidate_limits();
    }
 
    void static_text_box::value(string_view val)
@@ -594,8 +598,9 @@ namespace cycfi { namespace elements
          auto br = ctx.canvas.user_to_device(caret_bounds.right_bottom());
          caret_bounds = { tl.x, tl.y, br.x, br.y };
 
+         // The caret blinks with the app-wide blink clock
          _caret_started = true;
-         ctx.view.post(500ms,
+         ctx.view.post_tick(500ms,
             [this, &_view = ctx.view, caret_bounds]()
             {
                _show_caret = !_show_caret;
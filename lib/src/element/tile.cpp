@@ -90,6 +90,20 @@ namespace cycfi { namespace elements
          std::sort(elements.begin(), elements.end(),
             [](layout_info lhs, layout_info rhs){ return lhs.index < rhs.index; });
       }
+
+      // Find the tile that includes pos. Tile i spans the half-open
+      // interval [tiles[i-1]+origin, tiles[i]+origin), as computed by
+      // bounds_of, so this is the first tile that ends after pos. The
+      // edges are computed exactly as bounds_of does, so that the result
+      // always agrees with rect::includes: a point on an edge shared by two
+      // tiles is in the later one, and a point on the far edge of the last
+      // tile is in none.
+      std::size_t find_tile(std::vector<float> const& tiles, float origin, float pos)
+      {
+         auto i = std::upper_bound(tiles.begin(), tiles.end(), pos,
+            [origin](float x, float end) { return x < end + origin; });
+         return i - tiles.begin();
+      }
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -100,7 +114,7 @@ namespace cycfi { namespace elements
       view_limits limits{ { 0.0, 0.0 }, { full_extent, 0.0 } };
       for (std::size_t i = 0; i != size();  ++i)
       {
-         auto el = at(i).limits(ctx);
+         auto el = at(i).cached_limits(ctx);
 
          limits.min.y += el.min.y;
          limits.max.y += el.max.y;
@@ -123,7 +137,7 @@ namespace cycfi { namespace elements
       for (std::size_t i = 0; i != sz; ++i)
       {
          auto& elem = at(i);
-         auto limits = elem.limits(ctx);
+         auto limits = elem.cached_limits(ctx);
          info[i].stretch = elem.stretch().y;
          info[i].min = limits.min.y;
          info[i].max = limits.max.y;
@@ -150,7 +164,7 @@ namespace cycfi { namespace elements
 
          auto& elem = at(i);
          rect ebounds = { left, prev+top, right, curr+top };
-         elem.layout(context{ ctx, &elem, ebounds });
+         elem.update_layout(context{ ctx, &elem, ebounds }, i);
       }
    }
 
@@ -171,6 +185,14 @@ namespace cycfi { namespace elements
       return rect{ left, (index? _tiles[index-1] : 0)+top, right, _tiles[index]+top };
    }
 
+   vtile_element::hit_info vtile_element::hit_element(context const& ctx, point p, bool control) const
+   {
+      auto ix = find_tile(_tiles, ctx.bounds.top, p.y);
+      if (ix >= _tiles.size())
+         return hit_info{ {}, rect{}, -1 };
+      return hit_range(ctx, p, control, ix, ix+1);
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Horizontal Tiles
    ////////////////////////////////////////////////////////////////////////////
@@ -179,7 +201,7 @@ namespace cycfi { namespace elements
       view_limits limits{ { 0.0, 0.0 }, { 0.0, full_extent } };
       for (std::size_t i = 0; i != size();  ++i)
       {
-         auto el = at(i).limits(ctx);
+         auto el = at(i).cached_limits(ctx);
 
          limits.min.x += el.min.x;
          limits.max.x += el.max.x;
@@ -202,7 +224,7 @@ namespace cycfi { namespace elements
       for (std::size_t i = 0; i != sz; ++i)
       {
          auto& elem = at(i);
-         auto limits = elem.limits(ctx);
+         auto limits = elem.cached_limits(ctx);
          info[i].stretch = elem.stretch().x;
          info[i].min = limits.min.x;
          info[i].max = limits.max.x;
@@ -229,7 +251,7 @@ namespace cycfi { namespace elements
 
          auto& elem = at(i);
          rect ebounds = { prev+left, top, curr+left, bottom };
-         elem.layout(context{ ctx, &elem, ebounds });
+         elem.update_layout(context{ ctx, &elem, ebounds }, i);
       }
    }
 
@@ -249,4 +271,12 @@ namespace cycfi { namespace elements
       auto const left = ctx.bounds.left;
       return rect{ (index? _tiles[index-1] : 0)+left, top, _tiles[index]+left, bottom };
    }
+
+   htile_element::hit_info htile_element::hit_element(context const& ctx, point p, bool control) const
+   {
+      auto ix = find_tile(_tiles, ctx.bounds.left, p.x);
+      if (ix >= _tiles.size())
+         return hit_info{ {}, rect{}, -1 };
+      return hit_range(ctx, p, control, ix, ix+1);
+   }
 }}
@@ -10,7 +10,7 @@ namespace cycfi { namespace elements
 {
    rect tooltip_element::tip_bounds(context const& ctx) const
    {
-      auto [width, height] = _tip->limits(ctx).min;
+      auto [width, height] = _tip->cached_limits(ctx).min;
       auto ret = rect{0, 0, width, height};
       ret.reposition(ctx.bounds.left, ctx.bounds.top - height);
       return ret;
@@ -24,9 +24,11 @@ namespace cycfi { namespace elements
          {
             _tip_status = tip_delayed;
             _tip->bounds(tip_bounds(ctx));
-            ctx.view.post(std::chrono::duration_cast<std::chrono::milliseconds>(_delay),
+            ctx.view.cancel(_delay_timer);
+            _delay_timer = ctx.view.post(_delay,
                [this, &view_ = ctx.view, bounds = ctx.bounds]()
                {
+                  _delay_timer = {};
                   if (_tip_status == tip_delayed)
                   {
                      _tip->on_cursor =
@@ -47,6 +49,7 @@ namespace cycfi { namespace elements
       }
       else
       {
+         ctx.view.cancel(_delay_timer);
          ctx.view.post(
             [this, &view_ = ctx.view]()
             {
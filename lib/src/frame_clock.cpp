@@ -0,0 +1,74 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/frame_clock.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace elements
+{
+   frame_clock::frame_clock(request_function request_frame)
+    : _request_frame(std::move(request_frame))
+   {}
+
+   frame_clock::id_type frame_clock::add(frame_function f)
+   {
+      auto id = _next_id++;
+      bool was_running = is_running();
+      _subscribers.push_back({ id, std::move(f), true });
+
+      // While ticking, the next frame is requested after the tick
+      if (!was_running && !_in_tick && _request_frame)
+         _request_frame();
+      return id;
+   }
+
+   void frame_clock::remove(id_type id)
+   {
+      auto i = std::find_if(_subscribers.begin(), _subscribers.end(),
+         [id](auto const& s) { return s.id == id; });
+      if (i == _subscribers.end())
+         return;
+
+      // Subscribers removed while ticking are erased after the tick
+      if (_in_tick)
+         i->active = false;
+      else
+         _subscribers.erase(i);
+   }
+
+   void frame_clock::tick(time_point t)
+   {
+      _frame_time = t;
+      _in_tick = true;
+
+      // Subscribers added while ticking get their first tick next frame
+      auto size = _subscribers.size();
+      for (std::size_t i = 0; i != size; ++i)
+      {
+         if (!_subscribers[i].active)
+            continue;
+
+         // Move the function out while calling it: it may add subscribers,
+         // reallocating the list
+         auto f = std::move(_subscribers[i].f);
+         bool keep = f(t);
+         auto& s = _subscribers[i];
+         if (keep && s.active)
+            s.f = std::move(f);
+         else
+            s.active = false;
+      }
+
+      _subscribers.erase(
+         std::remove_if(_subscribers.begin(), _subscribers.end(),
+            [](auto const& s) { return !s.active; }),
+         _subscribers.end()
+      );
+      _in_tick = false;
+
+      if (is_running() && _request_frame)
+         _request_frame();
+   }
+}}
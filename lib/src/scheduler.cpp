@@ -0,0 +1,395 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/scheduler.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // task_queue
+   ////////////////////////////////////////////////////////////////////////////
+   scheduler::task_queue::task_queue(scheduler& s)
+    : _scheduler(s)
+   {}
+
+   void scheduler::task_queue::post(task f, priority p)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (_is_closed)
+            return;
+         _tasks[p].push_back(std::move(f));
+      }
+      mark_ready();
+   }
+
+   void scheduler::task_queue::post_idle(idle_task f)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (_is_closed)
+            return;
+         _idle.push_back(std::move(f));
+      }
+      mark_ready();
+   }
+
+   void scheduler::task_queue::mark_ready()
+   {
+      bool was_ready;
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         was_ready = _is_ready;
+         _is_ready = true;
+      }
+      if (!was_ready)
+         _scheduler.ready(shared_from_this());
+   }
+
+   void scheduler::task_queue::close()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _is_closed = true;
+      for (auto& tasks : _tasks)
+         tasks.clear();
+      _idle.clear();
+   }
+
+   bool scheduler::task_queue::is_closed()
+   {
+      // A task may close the queue (e.g. by destroying its view)
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _is_closed;
+   }
+
+   void scheduler::task_queue::start_run()
+   {
+      // Tasks posted while running are run in the next wakeup
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (int p = 0; p != num_priorities; ++p)
+         std::swap(_tasks[p], _running[p]);
+      _is_ready = false;
+   }
+
+   void scheduler::task_queue::run(priority p)
+   {
+      auto& tasks = _running[p];
+      for (auto& f : tasks)
+      {
+         if (is_closed())
+            break;
+         f();
+      }
+      tasks.clear();
+   }
+
+   bool scheduler::task_queue::push_notification(notification const& n)
+   {
+      if (!_notifications.push(n))
+         return false;
+      if (!_has_notifications.exchange(true))
+         _scheduler.notified();
+      return true;
+   }
+
+   void scheduler::task_queue::run_notifications()
+   {
+      if (!_has_notifications.exchange(false))
+         return;
+
+      // Drain the queue, and note the last notification of each key
+      auto& pending = _running_notifications;
+      notification n;
+      while (_notifications.pop(n))
+      {
+         if (n.key())
+            _last_notification[n.key()] = pending.size();
+         pending.push_back(n);
+      }
+
+      for (std::size_t i = 0; i != pending.size(); ++i)
+      {
+         auto const& n_ = pending[i];
+         if (n_.key() && _last_notification[n_.key()] != i)
+            continue; // superseded by a later notification
+         if (is_closed())
+            break;
+         n_();
+      }
+      pending.clear();
+      _last_notification.clear();
+   }
+
+   bool scheduler::task_queue::run_idle(time_point deadline)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         std::swap(_idle, _running_idle);
+      }
+
+      // Call the idle tasks in turn until they are done or the deadline
+      // passes. At least one is called, so that idle tasks always make
+      // progress.
+      std::size_t i = 0;
+      bool first = true;
+      while (!_running_idle.empty() && (first || clock_type::now() < deadline))
+      {
+         if (is_closed())
+            break;
+         if (i >= _running_idle.size())
+            i = 0;
+         if (_running_idle[i]())
+            ++i;
+         else
+            _running_idle.erase(_running_idle.begin() + i);
+         first = false;
+      }
+
+      // Put back the unfinished tasks, ahead of the tasks posted meanwhile
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_is_closed)
+      {
+         _running_idle.clear();
+         return false;
+      }
+      _running_idle.insert(_running_idle.end(),
+         std::make_move_iterator(_idle.begin()), std::make_move_iterator(_idle.end()));
+      _idle.clear();
+      std::swap(_idle, _running_idle);
+      return !_idle.empty();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // scheduler
+   ////////////////////////////////////////////////////////////////////////////
+   scheduler::scheduler()
+    : _epoch(clock_type::now())
+   {}
+
+   scheduler::io_context& scheduler::io()
+   {
+      // The caller is about to submit work: poll the io_context soon
+      wake_main_loop();
+      return _io;
+   }
+
+   scheduler::task_queue_ptr scheduler::make_queue()
+   {
+      auto q = std::make_shared<task_queue>(*this);
+      _all_queues.push_back(q);
+      return q;
+   }
+
+   void scheduler::notified()
+   {
+      // Called from any thread. wake_main_loop() does not lock.
+      _is_notified = true;
+      wake_main_loop();
+   }
+
+   void scheduler::run_notifications()
+   {
+      if (!_is_notified.exchange(false))
+         return;
+
+      for (auto i = _all_queues.begin(); i != _all_queues.end();)
+      {
+         if (auto queue = i->lock())
+         {
+            queue->run_notifications();
+            ++i;
+         }
+         else
+         {
+            i = _all_queues.erase(i);
+         }
+      }
+   }
+
+   void scheduler::ready(std::shared_ptr<task_queue> q)
+   {
+      bool is_polling;
+      {
+         std::lock_guard<std::mutex> lock(_ready_mutex);
+         _ready.push_back(q);
+         is_polling = _is_polling;
+      }
+
+      // poll() picks up queues made ready while running the timers
+      if (!is_polling)
+         wake_main_loop();
+   }
+
+   void scheduler::poll()
+   {
+      auto start = clock_type::now();
+      {
+         std::lock_guard<std::mutex> lock(_ready_mutex);
+         _is_polling = true;
+      }
+
+      run_notifications();
+
+      // Run the expired timers. These post their tasks to the queues.
+      run_timers();
+
+      // The io_context stops when it runs out of work
+      _io.restart();
+      _io.poll();
+
+      {
+         std::lock_guard<std::mutex> lock(_ready_mutex);
+         std::swap(_ready, _running);
+         _is_polling = false;
+      }
+
+      // Queues with idle tasks left from the previous frame
+      _running.insert(_running.end(), _idle.begin(), _idle.end());
+      _idle.clear();
+
+      auto& queues = _queues;
+      for (auto& q : _running)
+      {
+         if (auto queue = q.lock())
+         {
+            if (std::find(queues.begin(), queues.end(), queue) == queues.end())
+            {
+               queue->start_run();
+               queues.push_back(queue);
+            }
+         }
+      }
+      _running.clear();
+
+      // Run the tasks of all the queues, by priority
+      for (int p = 0; p != num_priorities; ++p)
+         for (auto& queue : queues)
+            queue->run(priority(p));
+
+      // Run the idle tasks with what remains of the idle budget. Queues
+      // with idle tasks left resume in the next frame.
+      auto deadline = start + _idle_budget;
+      for (auto& queue : queues)
+      {
+         if (queue->run_idle(deadline))
+            _idle.push_back(queue);
+      }
+      queues.clear();
+   }
+
+   scheduler::time_point scheduler::next_wake() const
+   {
+      auto now = clock_type::now();
+      auto t = time_point::max();
+
+      // Idle tasks resume in the next frame. Keep polling the io_context
+      // while it has work.
+      if (!_idle.empty())
+         t = now + tick_duration;
+      if (!_io.stopped())
+         t = std::min(t, now + io_poll_interval);
+
+      // The earliest pending timer. Each slot holds the timers of the
+      // ticks that map to it, one or more turns of the wheel ahead.
+      if (_num_timers)
+      {
+         auto earliest = std::numeric_limits<std::uint64_t>::max();
+         for (std::size_t i = 1; i <= wheel_size; ++i)
+         {
+            auto tick = _current_tick + i;
+            for (auto const& timer : _wheel[tick % wheel_size])
+               earliest = std::min(earliest, timer.tick);
+            if (earliest == tick)
+               break;
+         }
+         time_point wake = _epoch + earliest * tick_duration;
+         t = std::min(t, wake);
+      }
+      return t;
+   }
+
+   scheduler::timer_id scheduler::post(std::weak_ptr<task_queue> q, duration d, task f)
+   {
+      return post_at(std::move(q), clock_type::now() + d, std::move(f));
+   }
+
+   scheduler::timer_id scheduler::post_tick(std::weak_ptr<task_queue> q, duration period, task f)
+   {
+      // The next tick of the clock with the given period, counted from
+      // the scheduler's epoch
+      auto elapsed = clock_type::now() - _epoch;
+      auto ticks = (period.count() > 0)? (elapsed / period) + 1 : 0;
+      return post_at(std::move(q), _epoch + ticks * period, std::move(f));
+   }
+
+   scheduler::timer_id scheduler::post_at(std::weak_ptr<task_queue> q, time_point t, task f)
+   {
+      // Round up to the wheel's tick. Ticks that were already run are
+      // never visited again, so those timers go to the next tick.
+      auto offset = std::max(t - _epoch, duration::zero());
+      auto tick = std::uint64_t((offset + tick_duration - duration{ 1 }) / tick_duration);
+      tick = std::max(tick, _current_tick + 1);
+
+      auto id = _next_timer_id++;
+      _wheel[tick % wheel_size].push_back({ id, tick, std::move(q), std::move(f) });
+      ++_num_timers;
+
+      // Timers expiring in the same tick share the same wake time
+      wake_main_loop(_epoch + tick * tick_duration);
+      return { id, tick };
+   }
+
+   bool scheduler::cancel(timer_id id)
+   {
+      if (!id || id.tick <= _current_tick)
+         return false;
+
+      auto& slot = _wheel[id.tick % wheel_size];
+      auto i = std::find_if(slot.begin(), slot.end(),
+         [&](auto const& t) { return t.id == id.id; });
+      if (i == slot.end())
+         return false;
+
+      slot.erase(i);
+      --_num_timers;
+      return true;
+   }
+
+   void scheduler::run_timers()
+   {
+      auto now_tick = std::uint64_t((clock_type::now() - _epoch) / tick_duration);
+      if (now_tick <= _current_tick)
+         return;
+
+      // Visit the slots of the ticks since the last run, at most once each
+      auto first = _current_tick + 1;
+      auto last = std::min(now_tick, _current_tick + wheel_size);
+      _current_tick = now_tick;
+
+      for (auto tick = first; _num_timers && tick <= last; ++tick)
+      {
+         auto& slot = _wheel[tick % wheel_size];
+         auto i = std::stable_partition(slot.begin(), slot.end(),
+            [now_tick](auto const& t) { return t.tick > now_tick; });
+
+         // Post the expired timers' tasks to their queues
+         for (auto j = i; j != slot.end(); ++j)
+         {
+            if (auto queue = j->queue.lock())
+               queue->post(std::move(j->f));
+         }
+         _num_timers -= slot.end() - i;
+         slot.erase(i, slot.end());
+      }
+   }
+
+   scheduler& app_scheduler()
+   {
+      static scheduler scheduler_;
+      return scheduler_;
+   }
+}}
@@ -4,59 +4,209 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/support/canvas.hpp>
+#include <elements/support/detail/scratch_context.hpp>
+#include <elements/support/lru_cache.hpp>
 #include <cairo.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
 #include <memory>
 
 namespace cycfi { namespace elements
 {
    namespace
    {
-      struct cairo_pattern_deleter
+      using color_stop = canvas::color_stop;
+
+      void add_color_stops(cairo_pattern_t* pat, color_stop const* stops, std::size_t num_stops)
       {
-         void operator()(cairo_pattern_t* pattern) const
+         for (auto i = stops; i != stops + num_stops; ++i)
          {
-            if (pattern)
-               cairo_pattern_destroy(pattern);
+            cairo_pattern_add_color_stop_rgba(
+               pat, i->offset,
+               i->color.red, i->color.green, i->color.blue, i->color.alpha
+            );
          }
-      };
+      }
 
-      // use shared pointer instead of unique because std::function wants copyable types
-      using cairo_pattern_ptr = std::shared_ptr<cairo_pattern_t>;
+      ////////////////////////////////////////////////////////////////////////
+      // Gradient pattern cache. Patterns are keyed by their kind, their
+      // shape normalized to a unit box, and their color stops. The least
+      // recently used pattern is dropped when the cache gets full.
+      ////////////////////////////////////////////////////////////////////////
+      constexpr std::size_t max_cached_stops = 8;
+      constexpr std::size_t max_cached_patterns = 256;
 
-      cairo_pattern_ptr make_linear_pattern(canvas::linear_gradient const& gr)
+      struct gradient_key
       {
-         cairo_pattern_t* pat = cairo_pattern_create_linear(
-            gr.start.x, gr.start.y, gr.end.x, gr.end.y
-         );
+         bool operator==(gradient_key const& rhs) const
+         {
+            return kind == rhs.kind
+               && std::equal(std::begin(shape), std::end(shape), std::begin(rhs.shape))
+               && num_stops == rhs.num_stops
+               && std::equal(stops.begin(), stops.begin() + num_stops * 5, rhs.stops.begin());
+         }
 
-         for (auto cs : gr.space)
+         bool operator<(gradient_key const& rhs) const
          {
-            cairo_pattern_add_color_stop_rgba(
-               pat, cs.offset,
-               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
+            if (kind != rhs.kind)
+               return kind < rhs.kind;
+            if (num_stops != rhs.num_stops)
+               return num_stops < rhs.num_stops;
+            if (!std::equal(std::begin(shape), std::end(shape), std::begin(rhs.shape)))
+               return std::lexicographical_compare(
+                  std::begin(shape), std::end(shape), std::begin(rhs.shape), std::end(rhs.shape));
+            return std::lexicographical_compare(
+               stops.begin(), stops.begin() + num_stops * 5
+             , rhs.stops.begin(), rhs.stops.begin() + num_stops * 5
             );
          }
 
-         return cairo_pattern_ptr(pat, cairo_pattern_deleter{});
+         enum kind_type { linear, radial };
+
+         kind_type                              kind;
+         float                                  shape[3] = {};
+         std::size_t                            num_stops = 0;
+         std::array<float, max_cached_stops * 5> stops = {};
+      };
+
+      struct pattern_deleter
+      {
+         void operator()(cairo_pattern_t* pat) const { cairo_pattern_destroy(pat); }
+      };
+
+      using pattern_ptr = std::unique_ptr<cairo_pattern_t, pattern_deleter>;
+      using pattern_cache = lru_cache<gradient_key, pattern_ptr>;
+
+      pattern_cache& get_pattern_cache()
+      {
+         static pattern_cache cache{ max_cached_patterns };
+         return cache;
       }
 
-      cairo_pattern_ptr make_radial_pattern(canvas::radial_gradient const& gr)
+      // Quantize the normalized shape, so that gradients that differ only
+      // by rounding share the same pattern
+      float quantize(float v)
       {
-         cairo_pattern_t* pat = cairo_pattern_create_radial(
-            gr.c1.x, gr.c1.y, gr.c1_radius,
-            gr.c2.x, gr.c2.y, gr.c2_radius
-         );
+         return std::round(v * 1024.0f) / 1024.0f;
+      }
 
-         for (auto cs : gr.space)
+      bool make_key(gradient_key& key, color_stop const* stops, std::size_t num_stops)
+      {
+         if (num_stops > max_cached_stops)
+            return false;
+         key.num_stops = num_stops;
+         auto p = key.stops.begin();
+         for (auto i = stops; i != stops + num_stops; ++i)
          {
-            cairo_pattern_add_color_stop_rgba(
-               pat, cs.offset,
-               cs.color.red, cs.color.green, cs.color.blue, cs.color.alpha
-            );
+            *p++ = i->offset;
+            *p++ = i->color.red;
+            *p++ = i->color.green;
+            *p++ = i->color.blue;
+            *p++ = i->color.alpha;
          }
+         return true;
+      }
 
-         return cairo_pattern_ptr(pat, cairo_pattern_deleter{});
+      // Get the cached pattern for key, or make it with make_pattern.
+      // Returns a new reference.
+      template <typename F>
+      cairo_pattern_t* cached_pattern(
+         gradient_key const& key
+       , color_stop const* stops, std::size_t num_stops
+       , F make_pattern
+      )
+      {
+         auto& pat = get_pattern_cache().get(key,
+            [&]
+            {
+               auto pat_ = make_pattern();
+               add_color_stops(pat_, stops, num_stops);
+               return pattern_ptr{ pat_ };
+            }
+         );
+         return cairo_pattern_reference(pat.get());
+      }
+   }
+
+   canvas::style::style(cairo_pattern_t* pattern_, cairo_matrix_t const& transform)
+    : _kind(pattern)
+    , _pattern(pattern_)
+    , _has_transform(true)
+    , _transform{
+         transform.xx, transform.yx, transform.xy
+       , transform.yy, transform.x0, transform.y0
+      }
+   {}
+
+   canvas::style::style(color c)
+    : _kind(solid)
+    , _color(c)
+   {}
+
+   canvas::style::style(cairo_pattern_t* pattern_)
+    : _kind(pattern)
+    , _pattern(pattern_)
+   {}
+
+   canvas::style::style(style const& rhs)
+    : _kind(rhs._kind)
+    , _color(rhs._color)
+    , _pattern(rhs._pattern? cairo_pattern_reference(rhs._pattern) : nullptr)
+    , _has_transform(rhs._has_transform)
+   {
+      std::copy(std::begin(rhs._transform), std::end(rhs._transform), _transform);
+   }
+
+   canvas::style::style(style&& rhs) noexcept
+    : _kind(rhs._kind)
+    , _color(rhs._color)
+    , _pattern(rhs._pattern)
+    , _has_transform(rhs._has_transform)
+   {
+      std::copy(std::begin(rhs._transform), std::end(rhs._transform), _transform);
+      rhs._kind = none;
+      rhs._pattern = nullptr;
+   }
+
+   canvas::style::~style()
+   {
+      if (_pattern)
+         cairo_pattern_destroy(_pattern);
+   }
+
+   canvas::style& canvas::style::operator=(style rhs) noexcept
+   {
+      std::swap(_kind, rhs._kind);
+      std::swap(_color, rhs._color);
+      std::swap(_pattern, rhs._pattern);
+      std::swap(_has_transform, rhs._has_transform);
+      std::swap(_transform, rhs._transform);
+      return *this;
+   }
+
+   void canvas::style::apply(cairo_t& context_) const
+   {
+      if (_kind == solid)
+         cairo_set_source_rgba(&context_, _color.red, _color.green, _color.blue, _color.alpha);
+      else if (_kind == pattern && !_has_transform)
+         cairo_set_source(&context_, _pattern);
+      else if (_kind == pattern)
+      {
+         // The pattern is locked to the user space in effect when it is
+         // set: set it in the transformed user space, then restore the
+         // transform. The shared pattern's own matrix is left alone.
+         cairo_matrix_t m, t;
+         cairo_get_matrix(&context_, &m);
+         cairo_matrix_init(&t,
+            _transform[0], _transform[1], _transform[2]
+          , _transform[3], _transform[4], _transform[5]
+         );
+         cairo_transform(&context_, &t);
+         cairo_set_source(&context_, _pattern);
+         cairo_set_matrix(&context_, &m);
       }
    }
 
@@ -121,6 +271,54 @@ namespace cycfi { namespace elements
       return { float(x / _pre_scale), float(y / _pre_scale) };
    }
 
+   void canvas::damage(region const* damage_)
+   {
+      _damage = damage_;
+      _user_damage_valid = false;
+   }
+
+   region const* canvas::user_damage()
+   {
+      if (!_damage)
+         return nullptr;
+
+      cairo_matrix_t m;
+      cairo_get_matrix(&_context, &m);
+      double const mat[] = { m.xx, m.yx, m.xy, m.yy, m.x0, m.y0 };
+      if (_user_damage_valid && std::equal(std::begin(mat), std::end(mat), _user_damage_matrix))
+         return &_user_damage;
+
+      // Transform the damage to user coordinates. With rotation or skew,
+      // each rectangle becomes the bounds of its transformed corners.
+      _user_damage.clear();
+      for (auto const& r : _damage->rects())
+      {
+         point corners[] = {
+            device_to_user(r.left_top()), device_to_user(r.right_top())
+          , device_to_user(r.left_bottom()), device_to_user(r.right_bottom())
+         };
+         elements::rect ur = { corners[0].x, corners[0].y, corners[0].x, corners[0].y };
+         for (auto const& p : corners)
+         {
+            ur.left = std::min(ur.left, p.x);
+            ur.top = std::min(ur.top, p.y);
+            ur.right = std::max(ur.right, p.x);
+            ur.bottom = std::max(ur.bottom, p.y);
+         }
+         _user_damage.add(ur);
+      }
+
+      std::copy(std::begin(mat), std::end(mat), _user_damage_matrix);
+      _user_damage_valid = true;
+      return &_user_damage;
+   }
+
+   bool canvas::is_damaged(elements::rect r)
+   {
+      auto damage = user_damage();
+      return !damage || damage->intersects(r.inset(-overdraw_margin, -overdraw_margin));
+   }
+
    void canvas::begin_path()
    {
       cairo_new_path(&_context);
@@ -228,22 +426,78 @@ namespace cycfi { namespace elements
       cairo_close_path(&_context);
    }
 
+   canvas::path canvas::make_path(std::function<void(canvas&)> const& build)
+   {
+      detail::scratch_context::scope scratch{ detail::shared_scratch_context() };
+      canvas cnv{ *scratch.context() };
+      build(cnv);
+      return cnv.copy_path();
+   }
+
+   canvas::path canvas::copy_path() const
+   {
+      path p;
+      p._path.reset(cairo_copy_path(&_context), cairo_path_destroy);
+      double x1, y1, x2, y2;
+      cairo_path_extents(&_context, &x1, &y1, &x2, &y2);
+      p._bounds = { float(x1), float(y1), float(x2), float(y2) };
+      return p;
+   }
+
+   void canvas::add_path(path const& p)
+   {
+      if (p._path)
+         cairo_append_path(&_context, p._path.get());
+   }
+
+   void canvas::add_path(path const& p, point offset)
+   {
+      if (!p._path)
+         return;
+      cairo_matrix_t m;
+      cairo_get_matrix(&_context, &m);
+      cairo_translate(&_context, offset.x, offset.y);
+      cairo_append_path(&_context, p._path.get());
+      cairo_set_matrix(&_context, &m);
+   }
+
+   void canvas::add_path(path const& p, point offset, float rotation, point scale)
+   {
+      // A zero scale would leave the context in an error state
+      if (!p._path || scale.x == 0 || scale.y == 0)
+         return;
+
+      // cairo_append_path maps the path through the current transform, so
+      // replaying it with a transform is the same as replaying it in a
+      // transformed user space.
+      cairo_matrix_t m;
+      cairo_get_matrix(&_context, &m);
+      cairo_translate(&_context, offset.x, offset.y);
+      cairo_rotate(&_context, rotation);
+      cairo_scale(&_context, scale.x, scale.y);
+      cairo_append_path(&_context, p._path.get());
+      cairo_set_matrix(&_context, &m);
+   }
+
+   bool canvas::path::includes(point p) const
+   {
+      if (!_path || !_bounds.includes(p))
+         return false;
+      detail::scratch_context::scope scratch{ detail::shared_scratch_context() };
+      cairo_append_path(scratch.context(), _path.get());
+      return cairo_in_fill(scratch.context(), p.x, p.y);
+   }
+
    void canvas::fill_style(color c)
    {
-      _state.fill_style = [this, c]()
-      {
-         cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
-      };
+      _state.fill_style = c;
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
 
    void canvas::stroke_style(color c)
    {
-      _state.stroke_style = [this, c]()
-      {
-         cairo_set_source_rgba(&_context, c.red, c.green, c.blue, c.alpha);
-      };
+      _state.stroke_style = c;
       if (_state.pattern_set == _state.stroke_set)
          _state.pattern_set = _state.none_set;
    }
@@ -255,20 +509,94 @@ namespace cycfi { namespace elements
 
    void canvas::fill_style(linear_gradient const& gr)
    {
-      _state.fill_style = [this, pat = make_linear_pattern(gr)]()
+      fill_linear_gradient(gr.start, gr.end, gr.space.data(), gr.space.size());
+   }
+
+   void canvas::fill_style(radial_gradient const& gr)
+   {
+      fill_radial_gradient(
+         gr.c1, gr.c1_radius, gr.c2, gr.c2_radius
+       , gr.space.data(), gr.space.size()
+      );
+   }
+
+   void canvas::fill_linear_gradient(point start, point end, color_stops stops)
+   {
+      fill_linear_gradient(start, end, stops.begin(), stops.size());
+   }
+
+   void canvas::fill_radial_gradient(
+      point c1, float c1_radius
+    , point c2, float c2_radius
+    , color_stops stops
+   )
+   {
+      fill_radial_gradient(c1, c1_radius, c2, c2_radius, stops.begin(), stops.size());
+   }
+
+   void canvas::fill_linear_gradient(
+      point start, point end
+    , color_stop const* stops, std::size_t num_stops
+   )
+   {
+      // The unit gradient goes from (0, 0) to (1, 0). It is rotated and
+      // scaled to go from start to end.
+      float dx = end.x - start.x;
+      float dy = end.y - start.y;
+      gradient_key key{ gradient_key::linear };
+      if ((dx != 0 || dy != 0) && make_key(key, stops, num_stops))
       {
-         cairo_set_source(&_context, pat.get());
-      };
+         auto pat = cached_pattern(key, stops, num_stops,
+            []() { return cairo_pattern_create_linear(0, 0, 1, 0); });
+
+         cairo_matrix_t transform;
+         cairo_matrix_init(&transform, dx, dy, -dy, dx, start.x, start.y);
+         _state.fill_style = style{ pat, transform };
+      }
+      else
+      {
+         auto pat = cairo_pattern_create_linear(start.x, start.y, end.x, end.y);
+         add_color_stops(pat, stops, num_stops);
+         _state.fill_style = style{ pat };
+      }
+
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
 
-   void canvas::fill_style(radial_gradient const& gr)
+   void canvas::fill_radial_gradient(
+      point c1, float c1_radius
+    , point c2, float c2_radius
+    , color_stop const* stops, std::size_t num_stops
+   )
    {
-      _state.fill_style = [this, pat = make_radial_pattern(gr)]()
+      // The unit gradient's outer circle is the unit circle at the origin.
+      // It is scaled and moved to c2.
+      gradient_key key{ gradient_key::radial };
+      if (c2_radius > 0 && make_key(key, stops, num_stops))
       {
-         cairo_set_source(&_context, pat.get());
-      };
+         key.shape[0] = quantize((c1.x - c2.x) / c2_radius);
+         key.shape[1] = quantize((c1.y - c2.y) / c2_radius);
+         key.shape[2] = quantize(c1_radius / c2_radius);
+         auto pat = cached_pattern(key, stops, num_stops,
+            [&key]()
+            {
+               return cairo_pattern_create_radial(
+                  key.shape[0], key.shape[1], key.shape[2], 0, 0, 1
+               );
+            });
+
+         cairo_matrix_t transform;
+         cairo_matrix_init(&transform, c2_radius, 0, 0, c2_radius, c2.x, c2.y);
+         _state.fill_style = style{ pat, transform };
+      }
+      else
+      {
+         auto pat = cairo_pattern_create_radial(c1.x, c1.y, c1_radius, c2.x, c2.y, c2_radius);
+         add_color_stops(pat, stops, num_stops);
+         _state.fill_style = style{ pat };
+      }
+
       if (_state.pattern_set == _state.fill_set)
          _state.pattern_set = _state.none_set;
    }
@@ -389,13 +717,25 @@ namespace cycfi { namespace elements
    void canvas::save()
    {
       cairo_save(&_context);
-      _state_stack.push(_state);
+      if (_num_saved_states < max_saved_states)
+         _saved_states[_num_saved_states] = _state;
+      else
+         _state_overflow.push_back(_state);
+      ++_num_saved_states;
    }
 
    void canvas::restore()
    {
-      _state = _state_stack.top();
-      _state_stack.pop();
+      --_num_saved_states;
+      if (_num_saved_states < max_saved_states)
+      {
+         _state = std::move(_saved_states[_num_saved_states]);
+      }
+      else
+      {
+         _state = std::move(_state_overflow.back());
+         _state_overflow.pop_back();
+      }
       cairo_restore(&_context);
    }
 }}
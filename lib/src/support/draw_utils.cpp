@@ -4,20 +4,310 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/support/draw_utils.hpp>
+#include <elements/support/lru_cache.hpp>
 #include <elements/support/theme.hpp>
+#include <cairo.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace cycfi { namespace elements
 {
-   void draw_box_vgradient(canvas& cnv, rect bounds, float corner_radius)
+   namespace
    {
-      auto gradient = canvas::linear_gradient{
-               bounds.left_top(),
-               bounds.left_bottom()
+      constexpr std::size_t max_cached_paths = 64;
+      constexpr int radial_marks_divs = 50;
+
+      // The radial marks' minor and major ticks, centered at the origin
+      struct radial_marks_paths
+      {
+         canvas::path minor;
+         canvas::path major;
       };
 
-      gradient.add_color_stop({ 0.0f, rgba(255, 255, 255, 16) });
-      gradient.add_color_stop({ 0.8f, rgba(0, 0, 0, 16) });
-      cnv.fill_style(gradient);
+      // Get the radial marks for radius and size. Knobs of the same size
+      // share the same paths.
+      radial_marks_paths const& get_radial_marks(float radius, float size)
+      {
+         using key_type = std::pair<float, float>;
+         static lru_cache<key_type, radial_marks_paths> cache{ max_cached_paths };
+
+         auto make_ticks = [=](bool major)
+         {
+            using namespace radial_consts;
+            return canvas::make_path(
+               [=](canvas& cnv)
+               {
+                  float div = range / radial_marks_divs;
+                  for (int i = 0; i != radial_marks_divs+1; ++i)
+                  {
+                     bool is_major = (i % (radial_marks_divs / 10)) == 0;
+                     if (is_major != major)
+                        continue;
+
+                     float from = is_major? radius : radius - size / 4;
+                     float angle = offset + (M_PI / 2) + (i * div);
+                     float sin_ = std::sin(angle);
+                     float cos_ = std::cos(angle);
+                     float to = radius - (size / 2);
+
+                     cnv.move_to({ from * cos_, from * sin_ });
+                     cnv.line_to({ to * cos_, to * sin_ });
+                  }
+               }
+            );
+         };
+         return cache.get({ radius, size },
+            [&] { return radial_marks_paths{ make_ticks(false), make_ticks(true) }; }
+         );
+      }
+
+      //////////////////////////////////////////////////////////////////////
+      // Drop shadows
+      //
+      // A shadow is a blurred round rect mask (A8), rendered once per
+      // corner radius, blur and scale into a small 9-slice atlas: the
+      // corners are drawn as is, and the 1 pixel wide middle row and
+      // column are stretched to the shadow's size. The blur is a
+      // Gaussian, approximated by three box blur passes in each direction.
+      //////////////////////////////////////////////////////////////////////
+      constexpr std::size_t max_cached_shadows = 32;
+      constexpr int blur_passes = 3;
+
+      // Box blur the columns of the A8 image, with running sums kept per
+      // column and updated a row at a time, so that the inner loops run
+      // over contiguous pixels (and vectorize).
+      void box_blur_columns(
+         std::uint8_t* data, int width, int height, int stride, int radius
+       , std::vector<std::uint32_t>& sum, std::vector<std::uint8_t>& out
+      )
+      {
+         std::uint32_t const size = 2 * radius + 1;
+         std::uint32_t const inv = ((1u << 16) + size / 2) / size;
+
+         sum.assign(width, 0);
+         out.resize(std::size_t(width) * height);
+         for (int y = 0; y < std::min(radius, height); ++y)
+         {
+            auto row = data + y * stride;
+            for (int x = 0; x != width; ++x)
+               sum[x] += row[x];
+         }
+
+         for (int y = 0; y != height; ++y)
+         {
+            if (auto add = y + radius; add < height)
+            {
+               auto row = data + add * stride;
+               for (int x = 0; x != width; ++x)
+                  sum[x] += row[x];
+            }
+
+            // inv is rounded, so the average of a run of 255s can round
+            // up to 256 with large radii. Clamp it.
+            auto dest = out.data() + std::size_t(y) * width;
+            for (int x = 0; x != width; ++x)
+               dest[x] = std::uint8_t(std::min<std::uint32_t>((sum[x] * inv + (1u << 15)) >> 16, 255));
+
+            if (auto sub = y - radius; sub >= 0)
+            {
+               auto row = data + sub * stride;
+               for (int x = 0; x != width; ++x)
+                  sum[x] -= row[x];
+            }
+         }
+
+         for (int y = 0; y != height; ++y)
+            std::copy_n(out.data() + std::size_t(y) * width, width, data + y * stride);
+      }
+
+      void transpose(
+         std::uint8_t const* src, int width, int height, int src_stride
+       , std::uint8_t* dest, int dest_stride
+      )
+      {
+         for (int y = 0; y != height; ++y)
+            for (int x = 0; x != width; ++x)
+               dest[x * dest_stride + y] = src[y * src_stride + x];
+      }
+
+      // Blur the A8 image, in place
+      void gaussian_blur(std::uint8_t* data, int width, int height, int stride, int radius)
+      {
+         std::vector<std::uint32_t> sum;
+         std::vector<std::uint8_t> out;
+         for (int i = 0; i != blur_passes; ++i)
+            box_blur_columns(data, width, height, stride, radius, sum, out);
+
+         // Blur the rows as the columns of the transposed image
+         std::vector<std::uint8_t> t(std::size_t(width) * height);
+         transpose(data, width, height, stride, t.data(), height);
+         for (int i = 0; i != blur_passes; ++i)
+            box_blur_columns(t.data(), height, width, height, radius, sum, out);
+         transpose(t.data(), height, width, height, data, stride);
+      }
+
+      struct shadow_atlas : non_copyable
+      {
+         shadow_atlas(cairo_surface_t* surface_, int corner_, int pad_)
+          : surface(surface_), corner(corner_), pad(pad_)
+         {}
+
+         ~shadow_atlas() { cairo_surface_destroy(surface); }
+
+         cairo_surface_t*  surface;
+         int               corner;  // the size of the corner slices
+         int               pad;     // the blur's extent outside the shape
+      };
+
+      using shadow_atlas_ptr = std::shared_ptr<shadow_atlas>;
+
+      // Render the shadow atlas, in device pixels
+      shadow_atlas_ptr make_shadow_atlas(float corner_radius, float blur)
+      {
+         // Three box blurs of radius r spread the shape by 3r
+         int box_radius = std::max(1, int(std::round(blur / blur_passes)));
+         int pad = box_radius * blur_passes;
+         int radius = int(std::ceil(corner_radius));
+
+         // The shape's straight edges must extend past the middle row and
+         // column by the blur's extent, so that they blur uniformly
+         int corner = pad + radius + pad;
+         int size = 2 * corner + 1;
+
+         auto surface = cairo_image_surface_create(CAIRO_FORMAT_A8, size, size);
+         {
+            auto cr = cairo_create(surface);
+            canvas cnv{ *cr };
+            cnv.round_rect({ float(pad), float(pad), float(size - pad), float(size - pad) }, corner_radius);
+            cnv.fill_style(colors::black);
+            cnv.fill();
+            cairo_destroy(cr);
+         }
+
+         cairo_surface_flush(surface);
+         gaussian_blur(
+            cairo_image_surface_get_data(surface), size, size
+          , cairo_image_surface_get_stride(surface), box_radius
+         );
+         cairo_surface_mark_dirty(surface);
+
+         return std::make_shared<shadow_atlas>(surface, corner, pad);
+      }
+
+      // Get the shadow atlas, in device pixels
+      shadow_atlas_ptr get_shadow_atlas(float corner_radius, float blur)
+      {
+         using key_type = std::tuple<float, float>;
+         static lru_cache<key_type, shadow_atlas_ptr> cache{ max_cached_shadows };
+         return cache.get({ corner_radius, blur },
+            [=] { return make_shadow_atlas(corner_radius, blur); }
+         );
+      }
+   }
+
+   void draw_shadow(
+      canvas& cnv, rect bounds, float corner_radius, float blur, color c
+    , bool draw_center
+   )
+   {
+      auto& cr = cnv.cairo_context();
+
+      // The shadow is drawn in device space, one atlas pixel per device
+      // pixel, with the bounds snapped to whole pixels, so that the
+      // slices meet exactly
+      double x1 = bounds.left, y1 = bounds.top;
+      double x2 = bounds.right, y2 = bounds.bottom;
+      cairo_user_to_device(&cr, &x1, &y1);
+      cairo_user_to_device(&cr, &x2, &y2);
+      double sx = 1, sy = 0;
+      cairo_user_to_device_distance(&cr, &sx, &sy);
+      float scale = std::hypot(sx, sy);
+
+      // Quantize the scale, to limit the number of atlases
+      scale = std::max(std::round(scale * 4) / 4, 0.25f);
+      auto atlas = get_shadow_atlas(
+         std::round(corner_radius * scale), std::round(blur * scale)
+      );
+
+      int const pad = atlas->pad;
+      int const corner = atlas->corner;
+      int left = int(std::floor(std::min(x1, x2))) - pad;
+      int top = int(std::floor(std::min(y1, y2))) - pad;
+      int right = int(std::ceil(std::max(x1, x2))) + pad;
+      int bottom = int(std::ceil(std::max(y1, y2))) + pad;
+
+      // Small shadows get smaller corners
+      int cw = std::min(corner, (right - left) / 2);
+      int ch = std::min(corner, (bottom - top) / 2);
+      if (cw <= 0 || ch <= 0)
+         return;
+
+      int const size = 2 * corner + 1;
+      int const src_x[] = { 0, corner, corner + 1, size };
+      int const src_y[] = { 0, corner, corner + 1, size };
+      int const dest_x[] = { left, left + cw, right - cw, right };
+      int const dest_y[] = { top, top + ch, bottom - ch, bottom };
+
+      cairo_save(&cr);
+      cairo_identity_matrix(&cr);
+      cairo_set_source_rgba(&cr, c.red, c.green, c.blue, c.alpha);
+
+      auto pattern = cairo_pattern_create_for_surface(atlas->surface);
+      cairo_pattern_set_extend(pattern, CAIRO_EXTEND_PAD);
+
+      // The stretched slices sample only the atlas' middle row or column
+      cairo_pattern_set_filter(pattern, CAIRO_FILTER_NEAREST);
+      for (int row = 0; row != 3; ++row)
+      {
+         for (int col = 0; col != 3; ++col)
+         {
+            // Callers that draw over the shadow's middle (e.g. a panel
+            // over its drop shadow) skip it
+            if (row == 1 && col == 1 && !draw_center)
+               continue;
+
+            int dw = dest_x[col + 1] - dest_x[col];
+            int dh = dest_y[row + 1] - dest_y[row];
+            if (dw <= 0 || dh <= 0)
+               continue;
+
+            // Map the slice's destination to its source in the atlas. The
+            // corners are drawn 1:1 (unless shrunk), and the edges and the
+            // middle are stretched.
+            double scale_x = double(src_x[col + 1] - src_x[col]) / dw;
+            double scale_y = double(src_y[row + 1] - src_y[row]) / dh;
+            cairo_matrix_t m;
+            cairo_matrix_init(&m,
+               scale_x, 0, 0, scale_y
+             , src_x[col] - dest_x[col] * scale_x
+             , src_y[row] - dest_y[row] * scale_y
+            );
+            cairo_pattern_set_matrix(pattern, &m);
+
+            cairo_save(&cr);
+            cairo_rectangle(&cr, dest_x[col], dest_y[row], dw, dh);
+            cairo_clip(&cr);
+            cairo_mask(&cr, pattern);
+            cairo_restore(&cr);
+         }
+      }
+      cairo_pattern_destroy(pattern);
+      cairo_restore(&cr);
+   }
+
+   void draw_box_vgradient(canvas& cnv, rect bounds, float corner_radius)
+   {
+      cnv.fill_linear_gradient(
+         bounds.left_top(), bounds.left_bottom(),
+         {
+            { 0.0f, rgba(255, 255, 255, 16) },
+            { 0.8f, rgba(0, 0, 0, 16) }
+         }
+      );
 
       cnv.begin_path();
       cnv.round_rect(bounds, corner_radius);
@@ -39,7 +329,7 @@ namespace cycfi { namespace elements
       cnv.fill_style(c);
       cnv.fill();
 
-      // Simulated blurred shadow. cairo does not have blur yet :-(
+      // Blurred drop shadow, outside the panel
       {
          auto save = cnv.new_state();
 
@@ -49,54 +339,27 @@ namespace cycfi { namespace elements
          cnv.fill_rule(canvas::fill_odd_even);
          cnv.clip();
 
-         rect shr = bounds;
-         shr.left -= 2;
-         shr.top -= 2;
-         shr.right += 6;
-         shr.bottom += 6;
-         cnv.begin_path();
-         cnv.round_rect(shr, corner_radius*2);
-         cnv.fill_style(rgba(0, 0, 0, 20));
-         cnv.fill();
-
-         shr.left += 1;
-         shr.top += 1;
-         shr.right -= 2;
-         shr.bottom -= 2;
-         cnv.begin_path();
-         cnv.round_rect(shr, corner_radius*1.5);
-         cnv.fill_style(rgba(0, 0, 0, 30));
-         cnv.fill();
-
-         shr.left += 1;
-         shr.top += 1;
-         shr.right -= 2;
-         shr.bottom -= 2;
-         cnv.begin_path();
-         cnv.round_rect(shr, corner_radius);
-         cnv.fill_style(rgba(0, 0, 0, 40));
-         cnv.fill();
+         // The middle of the shadow is always under the panel
+         draw_shadow(cnv, bounds.move(2, 2), corner_radius, 4, rgba(0, 0, 0, 90), false);
       }
    }
 
    void draw_button(canvas& cnv, rect bounds, color c, float corner_radius)
    {
-      auto gradient = canvas::linear_gradient{
-               bounds.left_top(),
-               bounds.left_bottom()
-      };
-
       float const box_opacity = get_theme().element_background_opacity;
-      gradient.add_color_stop({ 0.0, rgb(255, 255, 255).opacity(box_opacity) });
-      gradient.add_color_stop({ 1.0, rgb(0, 0, 0).opacity(box_opacity) });
-      cnv.fill_style(gradient);
 
       cnv.begin_path();
       cnv.round_rect(bounds.inset(1, 1), corner_radius-1);
       cnv.fill_style(c);
       cnv.fill();
       cnv.round_rect(bounds.inset(1, 1), corner_radius-1);
-      cnv.fill_style(gradient);
+      cnv.fill_linear_gradient(
+         bounds.left_top(), bounds.left_bottom(),
+         {
+            { 0.0f, rgb(255, 255, 255).opacity(box_opacity) },
+            { 1.0f, rgb(0, 0, 0).opacity(box_opacity) }
+         }
+      );
       cnv.fill();
 
       cnv.begin_path();
@@ -113,16 +376,15 @@ namespace cycfi { namespace elements
 
       // Draw beveled knob
       {
-         auto gradient = canvas::radial_gradient{
+         cnv.fill_radial_gradient(
             { cp.cx, cp.cy }, radius*0.75f,
-            { cp.cx, cp.cy }, radius
-         };
-
-         gradient.add_color_stop({ 0.0, c });
-         gradient.add_color_stop({ 0.5, c.opacity(0.5) });
-         gradient.add_color_stop({ 1.0, c.level(0.5).opacity(0.5) });
-
-         cnv.fill_style(gradient);
+            { cp.cx, cp.cy }, radius,
+            {
+               { 0.0f, c },
+               { 0.5f, c.opacity(0.5) },
+               { 1.0f, c.level(0.5).opacity(0.5) }
+            }
+         );
          cnv.begin_path();
          cnv.circle(cp.inset(inset));
          cnv.fill();
@@ -130,18 +392,16 @@ namespace cycfi { namespace elements
 
       // Draw some 3D highlight
       {
-          auto hcp = cp.center();
-          hcp.move_to(-radius, -radius);
-          auto gradient = canvas::radial_gradient{
-                  hcp, radius*0.5f,
-                  hcp, radius*2
-          };
-
-		 using cs = canvas::color_stop;
-         gradient.add_color_stop(cs{ 0.0f, { 1.0f, 1.0f, 1.0f, 0.4f } });
-         gradient.add_color_stop(cs{ 1.0f, { 0.6f, 0.6f, 0.6f, 0.0f } });
-
-         cnv.fill_style(gradient);
+         auto hcp = cp.center();
+         hcp.move_to(-radius, -radius);
+         cnv.fill_radial_gradient(
+            hcp, radius*0.5f,
+            hcp, radius*2,
+            {
+               { 0.0f, { 1.0f, 1.0f, 1.0f, 0.4f } },
+               { 1.0f, { 0.6f, 0.6f, 0.6f, 0.0f } }
+            }
+         );
          cnv.begin_path();
          cnv.circle(cp.inset(inset));
          cnv.fill();
@@ -164,18 +424,15 @@ namespace cycfi { namespace elements
          cnv.clip();
 
          auto bounds = cp.bounds();
-         auto gradient = canvas::linear_gradient{
-                 bounds.left_top(),
-                 bounds.left_bottom()
-         };
-
-         gradient.add_color_stop({ 1.0, rgba(255, 255, 255, 64) });
-         gradient.add_color_stop({ 0.0, rgba(0, 0, 0, 32) });
-         cnv.fill_style(gradient);
-
          cnv.begin_path();
          cnv.rect(bounds);
-         cnv.fill_style(gradient);
+         cnv.fill_linear_gradient(
+            bounds.left_top(), bounds.left_bottom(),
+            {
+               { 1.0f, rgba(255, 255, 255, 64) },
+               { 0.0f, rgba(0, 0, 0, 32) }
+            }
+         );
          cnv.fill();
       }
    }
@@ -205,16 +462,14 @@ namespace cycfi { namespace elements
       {
          auto hcp = cp.center();
          hcp.move_to(-radius, -radius);
-         auto gradient = canvas::radial_gradient{
+         cnv.fill_radial_gradient(
             hcp, radius*0.5f,
-            hcp, radius*2
-         };
-
-		 using cs = canvas::color_stop;
-		 gradient.add_color_stop(cs{ 0.0f, { 1.0f, 1.0f, 1.0f, 0.4f } });
-         gradient.add_color_stop(cs{ 1.0f, { 0.6f, 0.6f, 0.6f, 0.0f } });
-
-         cnv.fill_style(gradient);
+            hcp, radius*2,
+            {
+               { 0.0f, { 1.0f, 1.0f, 1.0f, 0.4f } },
+               { 1.0f, { 0.6f, 0.6f, 0.6f, 0.0f } }
+            }
+         );
          cnv.begin_path();
          cnv.circle(cp);
          cnv.fill();
@@ -230,15 +485,15 @@ namespace cycfi { namespace elements
 
       // Add some outer bevel
       {
-         auto gradient = canvas::linear_gradient{
-            { cp.cx, cp.cy - cp.radius },
-            { cp.cx, cp.cy + cp.radius }
-         };
-
-         gradient.add_color_stop({ 0.0, colors::white.opacity(0.3) });
-         gradient.add_color_stop({ 0.5, colors::black.opacity(0.5) });
          cnv.fill_rule(canvas::fill_odd_even);
-         cnv.fill_style(gradient);
+         cnv.fill_linear_gradient(
+            { cp.cx, cp.cy - cp.radius },
+            { cp.cx, cp.cy + cp.radius },
+            {
+               { 0.0f, colors::white.opacity(0.3) },
+               { 0.5f, colors::black.opacity(0.5) }
+            }
+         );
 
          circle cpf = cp;
          cnv.begin_path();
@@ -302,41 +557,25 @@ namespace cycfi { namespace elements
 
    void draw_radial_marks(canvas& cnv, circle cp, float size, color c)
    {
-      using namespace radial_consts;
       auto state = cnv.new_state();
       auto center = cp.center();
-      constexpr auto num_divs = 50;
-      float div = range / num_divs;
       auto const& theme = get_theme();
+      auto const& marks = get_radial_marks(cp.radius, size);
 
       cnv.translate({ center.x, center.y });
-      cnv.stroke_style(theme.ticks_color);
-      for (int i = 0; i != num_divs+1; ++i)
-      {
-         float from = cp.radius;
-         if (i % (num_divs / 10))
-         {
-            // Minor ticks
-            from -= size / 4;
-            cnv.line_width(theme.minor_ticks_width);
-            cnv.stroke_style(c.level(theme.minor_ticks_level));
-         }
-         else
-         {
-            // Major ticks
-            cnv.line_width(theme.major_ticks_width);
-            cnv.stroke_style(c.level(theme.major_ticks_level));
-         }
 
-         float angle = offset + (M_PI / 2) + (i * div);
-         float sin_ = std::sin(angle);
-         float cos_ = std::cos(angle);
-         float to = cp.radius - (size / 2);
+      // Minor ticks
+      cnv.begin_path();
+      cnv.add_path(marks.minor);
+      cnv.line_width(theme.minor_ticks_width);
+      cnv.stroke_style(c.level(theme.minor_ticks_level));
+      cnv.stroke();
 
-         cnv.move_to({ from * cos_, from * sin_ });
-         cnv.line_to({ to * cos_, to * sin_ });
-         cnv.stroke();
-      }
+      // Major ticks
+      cnv.add_path(marks.major);
+      cnv.line_width(theme.major_ticks_width);
+      cnv.stroke_style(c.level(theme.major_ticks_level));
+      cnv.stroke();
    }
 
    void draw_radial_labels(
@@ -5,6 +5,7 @@
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
 #include <elements/support/font.hpp>
+#include <elements/support/trace.hpp>
 #include <infra/assert.hpp>
 
 #include <cairo.h>
@@ -630,6 +631,7 @@ namespace cycfi { namespace elements
 
    font::font(font_descr descr)
    {
+      trace_zone zone{ "font::font", "text" };
 #ifndef __APPLE__
       static free_type_library ft_lib;
 #endif
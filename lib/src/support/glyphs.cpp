@@ -5,10 +5,10 @@
 =============================================================================*/
 #include <elements/support/glyphs.hpp>
 #include <elements/support/detail/scratch_context.hpp>
+#include <elements/support/trace.hpp>
 
 namespace cycfi { namespace elements
 {
-   static detail::scratch_context scratch_context_;
 
    glyphs::glyphs(char const* first, char const* last)
     : _first(first)
@@ -142,9 +142,10 @@ namespace cycfi { namespace elements
    )
     : glyphs(first, last)
    {
-      canvas cnv{ *scratch_context_.context() };
+      detail::scratch_context::scope scratch{ detail::shared_scratch_context() };
+      canvas cnv{ *scratch.context() };
       cnv.font(font_, size);
-      auto cr = scratch_context_.context();
+      auto cr = scratch.context();
       _scaled_font = cairo_scaled_font_reference(cairo_get_scaled_font(cr));
       build(start);
    }
@@ -157,7 +158,6 @@ namespace cycfi { namespace elements
    )
     : glyphs(first, last)
    {
-      canvas cnv{ *scratch_context_.context() };
       _scaled_font = cairo_scaled_font_reference(source._scaled_font);
       build(start);
    }
@@ -231,6 +231,7 @@ namespace cycfi { namespace elements
 
    void master_glyphs::break_lines(float width, std::vector<glyphs>& lines)
    {
+      trace_zone zone{ "master_glyphs::break_lines", "text" };
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
 
       // reurn early if there's nothing to break
@@ -316,6 +317,7 @@ namespace cycfi { namespace elements
 
    void master_glyphs::build(point start)
    {
+      trace_zone zone{ "master_glyphs::build", "text" };
       // reurn early if there's nothing to build
       if (_first == _last)
          return;
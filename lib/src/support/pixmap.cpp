@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/support/pixmap.hpp>
 #include <elements/support/resource_paths.hpp>
+#include <elements/support/trace.hpp>
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_PNG 1
 #include <elements/support/detail/stb_image.h>
@@ -28,6 +29,7 @@ namespace cycfi { namespace elements
    pixmap::pixmap(char const* filename, float scale)
     : _surface(nullptr)
    {
+      trace_zone zone{ "pixmap::load", "image" };
       auto  path = std::string(filename);
       auto  pos = path.find_last_of(".");
       if (pos == std::string::npos)
@@ -0,0 +1,78 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/region.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      inline float area(rect const& r)
+      {
+         return r.width() * r.height();
+      }
+   }
+
+   void region::add(rect r)
+   {
+      if (r.is_empty())
+         return;
+
+      // Merge r with all the rectangles it overlaps. Merging may make it
+      // overlap others, so repeat until there are none.
+      for (bool merged = true; merged;)
+      {
+         merged = false;
+         for (auto i = _rects.begin(); i != _rects.end(); ++i)
+         {
+            if (i->includes(r))
+               return;
+            if (i->is_intersects(r))
+            {
+               r = r.reconstruct_max_with(*i);
+               _rects.erase(i);
+               merged = true;
+               break;
+            }
+         }
+      }
+
+      _rects.push_back(r);
+      _bounds = (_rects.size() == 1)? r : _bounds.reconstruct_max_with(r);
+      if (_rects.size() > max_rects)
+         merge_cheapest();
+   }
+
+   void region::merge_cheapest()
+   {
+      // Find the pair of rectangles whose union adds the least area
+      std::size_t a = 0, b = 1;
+      float least = std::numeric_limits<float>::max();
+      for (std::size_t i = 0; i != _rects.size(); ++i)
+      {
+         for (std::size_t j = i + 1; j != _rects.size(); ++j)
+         {
+            auto u = _rects[i].reconstruct_max_with(_rects[j]);
+            auto waste = area(u) - area(_rects[i]) - area(_rects[j]);
+            if (waste < least)
+            {
+               least = waste;
+               a = i;
+               b = j;
+            }
+         }
+      }
+
+      rect u = _rects[a].reconstruct_max_with(_rects[b]);
+      _rects.erase(_rects.begin() + b);
+      _rects.erase(_rects.begin() + a);
+
+      // The union may overlap other rectangles: add it back. The bounds
+      // do not change.
+      add(u);
+   }
+}}
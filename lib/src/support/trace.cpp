@@ -0,0 +1,179 @@
+/*=============================================================================
+   Copyright (c) 2016-2020 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/trace.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__GNUG__)
+# include <cxxabi.h>
+#endif
+
+namespace cycfi { namespace elements
+{
+   namespace detail
+   {
+      std::atomic<bool> tracing_on{ false };
+   }
+
+   namespace
+   {
+      using clock = std::chrono::steady_clock;
+
+      struct trace_event
+      {
+         char const*       name;
+         char const*       category;
+         bool              is_type;
+         clock::time_point start;
+         clock::time_point end;
+         std::size_t       thread_id;
+      };
+
+      struct trace_state
+      {
+         trace_state()
+         {
+            if (auto path = std::getenv("ELEMENTS_TRACE"); path && *path)
+               start(path);
+         }
+
+         ~trace_state()
+         {
+            stop();
+         }
+
+         void start(fs::path const& path_)
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.clear();
+            path = path_;
+            origin = clock::now();
+            detail::tracing_on = true;
+         }
+
+         void stop()
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!detail::tracing_on)
+               return;
+            detail::tracing_on = false;
+            write();
+            events.clear();
+         }
+
+         void write() const;
+
+         std::mutex                 mutex;
+         std::vector<trace_event>   events;
+         fs::path                   path;
+         clock::time_point          origin;
+      };
+
+      trace_state& state()
+      {
+         static trace_state state_;
+         return state_;
+      }
+
+      // Start tracing at startup if ELEMENTS_TRACE is set
+      struct init_trace_state
+      {
+         init_trace_state() { state(); }
+      };
+
+      init_trace_state init;
+
+      // Small sequential thread ids read better in trace viewers
+      std::size_t this_thread_id()
+      {
+         static std::atomic<std::size_t> next_id{ 1 };
+         thread_local std::size_t id = next_id++;
+         return id;
+      }
+
+      std::string type_name(char const* name)
+      {
+#if defined(__GNUG__)
+         int status = 0;
+         char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+         if (demangled && status == 0)
+         {
+            std::string result = demangled;
+            std::free(demangled);
+            return result;
+         }
+#endif
+         return name;
+      }
+
+      void write_json_string(std::FILE* file, std::string const& s)
+      {
+         std::fputc('"', file);
+         for (auto c : s)
+         {
+            if (c == '"' || c == '\\')
+               std::fputc('\\', file);
+            if (static_cast<unsigned char>(c) >= 0x20)
+               std::fputc(c, file);
+         }
+         std::fputc('"', file);
+      }
+
+      void trace_state::write() const
+      {
+         auto file = std::fopen(path.string().c_str(), "w");
+         if (!file)
+            return;
+
+         using us = std::chrono::duration<double, std::micro>;
+         std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+         bool first = true;
+         for (auto const& e : events)
+         {
+            if (!first)
+               std::fputc(',', file);
+            first = false;
+            std::fputs("\n{\"name\":", file);
+            write_json_string(file, e.is_type? type_name(e.name) : e.name);
+            std::fputs(",\"cat\":", file);
+            write_json_string(file, e.category);
+            std::fprintf(file,
+               ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu}",
+               us(e.start - origin).count(),
+               us(e.end - e.start).count(),
+               e.thread_id
+            );
+         }
+         std::fputs("\n]}\n", file);
+         std::fclose(file);
+      }
+   }
+
+   void start_tracing(fs::path const& path)
+   {
+      state().start(path);
+   }
+
+   void stop_tracing()
+   {
+      state().stop();
+   }
+
+   trace_zone::~trace_zone()
+   {
+      if (!_active || !is_tracing())
+         return;
+
+      auto end = clock::now();
+      auto thread_id = this_thread_id();
+      auto& s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.events.push_back({ _name, _category, _is_type, _start, end, thread_id });
+   }
+}}
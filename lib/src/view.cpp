@@ -5,26 +5,37 @@
 =============================================================================*/
 #include <elements/view.hpp>
 #include <elements/window.hpp>
+#include <elements/element/cached.hpp>
 #include <elements/support/context.hpp>
+#include <elements/support/detail/scratch_context.hpp>
+#include <elements/support/trace.hpp>
+
+#include <algorithm>
 
  namespace cycfi { namespace elements
  {
    view::view(extent size_)
     : base_view(size_)
     , _main_element(make_scaled_content())
-    , _work(_io)
+    , _tasks(app_scheduler().make_queue())
+    , _frame_clock([this]() { schedule_frame(); })
+    , _ui_thread(std::this_thread::get_id())
    {}
 
    view::view(host_view_handle h)
     : base_view(h)
     , _main_element(make_scaled_content())
-    , _work(_io)
+    , _tasks(app_scheduler().make_queue())
+    , _frame_clock([this]() { schedule_frame(); })
+    , _ui_thread(std::this_thread::get_id())
    {}
 
    view::view(window& win)
     : base_view(win.host())
     , _main_element(make_scaled_content())
-    , _work(_io)
+    , _tasks(app_scheduler().make_queue())
+    , _frame_clock([this]() { schedule_frame(); })
+    , _ui_thread(std::this_thread::get_id())
    {
       on_change_limits = [&win](view_limits limits_)
       {
@@ -35,7 +46,8 @@
 
    view::~view()
    {
-      _io.stop();
+      // Discard the pending tasks and timers
+      _tasks->close();
    }
 
    void view::set_limits()
@@ -43,23 +55,20 @@
       if (_content.empty())
          return;
 
-      auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-      auto context_ = cairo_create(surface_);
-      canvas cnv{ *context_ };
+      trace_zone zone{ "view::set_limits" };
+      detail::scratch_context::scope scratch{ detail::shared_scratch_context() };
+      canvas cnv{ *scratch.context() };
       cnv.pre_scale(hdpi_scale());
 
       // Update the limits and constrain the window size to the limits
       basic_context bctx{ *this, cnv };
-      auto limits_ = _main_element.limits(bctx);
+      auto limits_ = _main_element.cached_limits(bctx);
       if (limits_.min != _current_limits.min || limits_.max != _current_limits.max)
       {
          _current_limits = limits_;
          if (on_change_limits)
             on_change_limits(limits_);
       }
-
-      cairo_surface_destroy(surface_);
-      cairo_destroy(context_);
    }
 
    void view::draw(cairo_t* context_, rect dirty_)
@@ -67,13 +76,30 @@
       if (_content.empty())
          return;
 
-      _dirty = dirty_;
+      trace_zone zone{ "view::draw" };
+
+      // The damage is the clip set by the host, if it is a list of
+      // rectangles, or dirty_ otherwise
+      _dirty.clear();
+      if (auto* list = cairo_copy_clip_rectangle_list(context_))
+      {
+         if (list->status == CAIRO_STATUS_SUCCESS)
+            for (int i = 0; i != list->num_rectangles; ++i)
+            {
+               auto const& r = list->rectangles[i];
+               _dirty.add({ float(r.x), float(r.y), float(r.x + r.width), float(r.y + r.height) });
+            }
+         cairo_rectangle_list_destroy(list);
+      }
+      if (_dirty.empty())
+         _dirty.add(dirty_);
 
       // Update the limits and constrain the window size to the limits
       set_limits();
 
       canvas cnv{ *context_ };
       cnv.pre_scale(hdpi_scale());
+      cnv.damage(&_dirty);
       auto size_ = size();
       rect subj_bounds = { 0, 0, size_.width, size_.height };
       context ctx{ *this, cnv, &_main_element, subj_bounds };
@@ -82,7 +108,7 @@
       if (subj_bounds != _current_bounds)
       {
          _current_bounds = subj_bounds;
-         _main_element.layout(ctx);
+         _main_element.update_layout(ctx);
       }
 
       // draw the subject
@@ -94,21 +120,43 @@
       template <typename F, typename This>
       void call(F f, This& self, rect _current_bounds)
       {
-         auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-         auto context_ = cairo_create(surface_);
-         canvas cnv{ *context_ };
+         // Reuse the shared scratch context instead of creating a new
+         // surface and context for each event
+         detail::scratch_context::scope scratch{ detail::shared_scratch_context() };
+         canvas cnv{ *scratch.context() };
          cnv.pre_scale(self.hdpi_scale());
          context ctx { self, cnv, &self.main_element(), _current_bounds };
 
          f(ctx, self.main_element());
+      }
+   }
 
-         cairo_surface_destroy(surface_);
-         cairo_destroy(context_);
+   namespace
+   {
+      // Invalidate the limits and layout of e and all its contents.
+      void invalidate_subtree(element& e)
+      {
+         e.invalidate_limits();
+         if (auto p = dynamic_cast<proxy_base*>(&e))
+         {
+            invalidate_subtree(p->subject());
+         }
+         else if (auto c = dynamic_cast<container*>(&e))
+         {
+            for (std::size_t ix = 0; ix != c->size(); ++ix)
+               invalidate_subtree(c->at(ix));
+         }
+         else if (auto i = dynamic_cast<indirect_base*>(&e))
+         {
+            invalidate_subtree(i->get());
+         }
       }
    }
 
    void view::layout()
    {
+      trace_zone zone{ "view::layout" };
+      invalidate_all_limits();
       if (_current_bounds.is_empty())
          return;
 
@@ -122,15 +170,72 @@
 
    void view::layout(element &element)
    {
+      // Invalidate the element, its contents and its ancestors. All other
+      // elements are laid out again only if their bounds changed.
+      if (invalidate_layout_path(element))
+         invalidate_subtree(element);
+      else
+         invalidate_all_limits();
+
       if (_current_bounds.is_empty())
          return;
 
+      incremental_layout();
+      refresh(element);
+   }
+
+   bool view::invalidate_layout_path(element& e)
+   {
+      // Invalidate e and its ancestors, found by following its layout
+      // parents up to the main element, in O(depth). Returns false if the
+      // path does not lead to the main element (e.g. e was never laid out
+      // in this view). The depth limit guards against cycles.
+      constexpr std::size_t max_depth = 256;
+      std::size_t depth = 0;
+      for (element* p = &e; p != &_main_element; p = p->layout_parent())
+      {
+         if (!p || ++depth == max_depth)
+            return false;
+      }
+
+      for (element* p = &e;; p = p->layout_parent())
+      {
+         // Indirect elements lay out what they refer to directly
+         p->invalidate_limits();
+         if (auto i = dynamic_cast<indirect_base*>(p))
+            i->get().invalidate_limits();
+         if (p == &_main_element)
+            break;
+      }
+      return true;
+   }
+
+   void view::invalidate_all_limits()
+   {
+      _limits_generation = new_limits_generation();
+   }
+
+   void view::incremental_layout()
+   {
+      trace_zone zone{ "view::layout" };
       call(
-         [](auto const& ctx, auto& _main_element) { _main_element.layout(ctx); },
+         [](auto const& ctx, auto& _main_element) { _main_element.update_layout(ctx); },
          *this, _current_bounds
       );
+   }
 
-      refresh(element);
+   void view::relayout_content()
+   {
+      // Called when content layers are added or removed. Only the content
+      // and its ancestors need to be laid out again.
+      _content.invalidate_limits();
+      _main_element.subject().invalidate_limits();
+      _main_element.invalidate_limits();
+      if (_current_bounds.is_empty())
+         return;
+
+      incremental_layout();
+      refresh();
    }
 
    float view::scale() const
@@ -141,29 +246,84 @@
    void view::scale(float val)
    {
       _main_element.scale(val);
+      invalidate_all_limits();
       refresh();
    }
 
    void view::refresh()
    {
-      // Allow refresh to be called from another thread
-      _io.post(
-         [this]()
-         {
-            base_view::refresh();
-         }
-      );
+      if (std::this_thread::get_id() == _ui_thread)
+         return batch_refresh();
+
+      // From another thread, without locking or allocating. At most one
+      // full refresh is pending at a time. The post fallback (which locks
+      // and allocates) is taken only if the notification queue is full.
+      if (_refresh_pending.exchange(true))
+         return;
+      auto f = [this]()
+      {
+         _refresh_pending = false;
+         batch_refresh();
+      };
+      if (!notify(this, f))
+         post(scheduler::paint, f);
    }
 
    void view::refresh(rect area)
    {
-      // Allow refresh to be called from another thread
-      _io.post(
-         [this, area]()
-         {
-            base_view::refresh(area);
-         }
-      );
+      if (std::this_thread::get_id() == _ui_thread)
+         return batch_refresh(area);
+
+      // From another thread. A pending full refresh covers the area. If
+      // the notification queue is full, refresh the whole view instead.
+      if (_refresh_pending.load())
+         return;
+      auto f = [this, area]() { batch_refresh(area); };
+      if (!notify(nullptr, f))
+         refresh();
+   }
+
+   void view::batch_refresh()
+   {
+      // While the frame clock runs, refreshes are painted once per frame
+      if (!_frame_clock.is_running())
+         base_view::refresh();
+      else
+         _refresh_all = true;
+   }
+
+   void view::batch_refresh(rect area)
+   {
+      if (!_frame_clock.is_running())
+         base_view::refresh(area);
+      else
+         _pending_refresh.add(area);
+   }
+
+   void view::schedule_frame()
+   {
+      if (_frame_scheduled)
+         return;
+      _frame_scheduled = true;
+
+      // Use a synthetic frame clock if the host has none
+      if (!request_frame())
+         post_tick(scheduler::tick_duration, [this]() { frame(now()); });
+   }
+
+   void view::frame(frame_time t)
+   {
+      _frame_scheduled = false;
+      _frame_clock.tick(t);
+
+      // Paint the refreshes batched during the frame
+      if (_refresh_all)
+         base_view::refresh();
+      else
+         for (auto const& r : _pending_refresh.rects())
+            base_view::refresh(r);
+      _refresh_all = false;
+      _pending_refresh.clear();
    }
 
    void view::refresh(element& element, int outward)
@@ -171,22 +331,69 @@
       if (_current_bounds.is_empty())
          return;
 
-      _io.post(
-         [this, &element, outward]()
+      // Find the element's bounds now, while it is known to exist. A task
+      // posted for later may run after the element is destroyed (e.g.
+      // view::remove refreshes an element, then drops it).
+      find_refresh_path(element);
+      call(
+         [&element, outward](auto const& ctx, auto& _main_element)
          {
-            call(
-               [&element, outward](auto const& ctx, auto& _main_element)
-               {
-                  _main_element.refresh(ctx, element, outward);
-               },
-               *this, _current_bounds
-            );
-         }
+            _main_element.refresh(ctx, element, outward);
+         },
+         *this, _current_bounds
       );
+      _refresh_path.clear();
+   }
+
+   bool view::find_refresh_path(element const& e)
+   {
+      // Follow the element's layout parents up to the main element, and
+      // note the steps, outermost first. Composites along the path then
+      // descend only into the child on the path (see on_refresh_path). The
+      // depth limit guards against cycles when a shared element was laid
+      // out in more than one place.
+      constexpr std::size_t max_depth = 256;
+      _refresh_path.clear();
+      _refresh_path_next = 0;
+      for (element const* child = &e; child != &_main_element;)
+      {
+         auto parent = child->layout_parent();
+         if (!parent || _refresh_path.size() == max_depth)
+         {
+            _refresh_path.clear();
+            return false;
+         }
+         _refresh_path.push_back({ parent, child, child->layout_index() });
+         child = parent;
+      }
+      std::reverse(_refresh_path.begin(), _refresh_path.end());
+      return true;
+   }
+
+   view::path_step const* view::on_refresh_path(element const* parent) const
+   {
+      // Composites along the path ask from the outermost down, so resume
+      // the search where the previous one matched.
+      for (auto i = _refresh_path_next; i < _refresh_path.size(); ++i)
+      {
+         if (_refresh_path[i].parent == parent)
+         {
+            _refresh_path_next = i+1;
+            return &_refresh_path[i];
+         }
+      }
+      return nullptr;
    }
 
    void view::refresh(context const& ctx, int outward)
    {
+      // The element changed: invalidate the caches that hold it
+      for (auto p = &ctx; p; p = p->parent)
+      {
+         if (auto c = dynamic_cast<cached_element*>(p->element))
+            c->invalidate_cache();
+      }
+
       context const* ctx_ptr = &ctx;
       while (outward > 0 && ctx_ptr)
       {
@@ -238,15 +445,107 @@
          return;
 
       call(
-         [p, status](auto const& ctx, auto& _main_element)
+         [this, p, status](auto const& ctx, auto& _main_element)
          {
+            // If the cursor is still on the path it was on in the last
+            // cursor event, composites along the path skip their hit tests.
+            _cursor_path_valid =
+               status == cursor_tracking::hovering && validate_cursor_path(ctx, p);
+            _cursor_path_next = 0;
+            if (!_cursor_path_valid)
+               _cursor_path.clear();
+
             if (!_main_element.cursor(ctx, p, status))
                set_cursor(cursor_type::arrow);
+            _cursor_path_valid = false;
          },
          *this, _current_bounds
       );
    }
 
+   void view::track_cursor_path(context const& ctx)
+   {
+      // Called by composites with the context of the element the cursor
+      // is on. The innermost composite is called last.
+      _cursor_path.clear();
+      for (auto p = &ctx; p; p = p->parent)
+         _cursor_path.push_back(p->element);
+      std::reverse(_cursor_path.begin(), _cursor_path.end());
+      _cursor_path_epoch = layout_epoch();
+   }
+
+   bool view::on_cursor_path(element const& parent, element const& child) const
+   {
+      if (!_cursor_path_valid)
+         return false;
+
+      // Composites along the path ask from the outermost down, so resume
+      // the search where the previous one matched.
+      for (auto i = _cursor_path_next; i+1 < _cursor_path.size(); ++i)
+      {
+         if (_cursor_path[i] == &parent)
+         {
+            _cursor_path_next = i+1;
+            return _cursor_path[i+1] == &child;
+         }
+      }
+      return false;
+   }
+
+   namespace
+   {
+      // Check that the elements in path, from index i down, are still the
+      // ones hit at p: each must be its parent's cursor tracking element,
+      // include p, and not be obscured by a sibling. The last one must
+      // still be hit.
+      bool validate_path(
+         context const& ctx, std::vector<element*> const& path
+       , std::size_t i, point p
+      )
+      {
+         auto& e = *path[i];
+         if (i+1 == path.size())
+            return e.hit_test(ctx, p) != nullptr;
+
+         auto next = path[i+1];
+         element* parent = &e;
+         if (auto ind = dynamic_cast<indirect_base*>(parent))
+            parent = &ind->get();
+
+         if (auto c = dynamic_cast<composite_base*>(parent))
+         {
+            auto ix = c->cursor_tracking_index();
+            if (ix < 0 || std::size_t(ix) >= c->size() || &c->at(ix) != next)
+               return false;
+            rect bounds = c->bounds_of(ctx, ix);
+            if (!next->wants_control() || !bounds.includes(p) || c->hit_preceding(ctx, p, ix))
+               return false;
+            context ectx{ ctx, next, bounds };
+            return validate_path(ectx, path, i+1, p);
+         }
+         else if (auto pr = dynamic_cast<proxy_base*>(parent))
+         {
+            if (&pr->subject() != next)
+               return false;
+            context sctx{ ctx, next, ctx.bounds };
+            pr->prepare_subject(sctx, p);
+            auto r = validate_path(sctx, path, i+1, p);
+            pr->restore_subject(sctx);
+            return r;
+         }
+         return false;
+      }
+   }
+
+   bool view::validate_cursor_path(context const& ctx, point p)
+   {
+      if (_cursor_path.empty()
+         || _cursor_path.front() != &_main_element
+         || _cursor_path_epoch != layout_epoch())
+         return false;
+      return validate_path(ctx, _cursor_path, 0, p);
+   }
+
    void view::scroll(point dir, point p)
    {
       if (_content.empty())
@@ -348,20 +647,101 @@
       refresh();
    }
 
+   view::time_point view::now() const
+   {
+      return _manual_clock? _manual_now : clock_type::now();
+   }
+
+   void view::manual_clock(bool enable)
+   {
+      // With a manual clock, time advances only through advance_clock,
+      // starting from zero, and timers posted with post(duration, f) are
+      // run by advance_clock. Pending manual timers are discarded when
+      // the manual clock is disabled.
+      _manual_clock = enable;
+      _manual_now = time_point{};
+      _manual_timers.clear();
+   }
+
+   view::timer_id view::post_timer(duration d, bool aligned, std::function<void()> f)
+   {
+      if (!_manual_clock)
+      {
+         auto& s = app_scheduler();
+         return aligned? s.post_tick(_tasks, d, std::move(f)) : s.post(_tasks, d, std::move(f));
+      }
+
+      // With a manual clock, aligned timers tick from time zero
+      auto t = _manual_now + d;
+      if (aligned && d.count() > 0)
+         t = time_point{ ((_manual_now.time_since_epoch() / d) + 1) * d };
+      auto id = _next_manual_timer_id++;
+      _manual_timers.emplace(t, manual_timer{ id, std::move(f) });
+      return { id, 0 };
+   }
+
+   void view::cancel(timer_id& id)
+   {
+      if (!id)
+         return;
+
+      if (_manual_clock)
+      {
+         auto i = std::find_if(_manual_timers.begin(), _manual_timers.end(),
+            [&](auto const& t) { return t.second.first == id.id; });
+         if (i != _manual_timers.end())
+            _manual_timers.erase(i);
+      }
+      else
+      {
+         app_scheduler().cancel(id);
+      }
+      id = {};
+   }
+
+   void view::advance_clock(clock_type::duration d)
+   {
+      if (!_manual_clock)
+         return;
+
+      // Run the timers that are due, in order, including timers posted
+      // by them that are due as well
+      auto until = _manual_now + d;
+      while (!_manual_timers.empty() && _manual_timers.begin()->first <= until)
+      {
+         auto i = _manual_timers.begin();
+         _manual_now = i->first;
+         auto f = std::move(i->second.second);
+         _manual_timers.erase(i);
+         f();
+      }
+      _manual_now = until;
+      poll();
+   }
+
    void view::poll()
    {
-      _io.poll();
-      if (_tracking_state != tracking::none)
+      app_scheduler().poll();
+   }
+
+   void view::check_tracking()
+   {
+      if (_tracking_state == tracking::none)
+         return;
+
+      using namespace std::chrono_literals;
+      auto now_ = now();
+      if ((now_ - _tracking_time) >= 1s)
       {
-         using namespace std::chrono_literals;
-         auto now = std::chrono::steady_clock::now();
-         if ((now - _tracking_time) > 1s)
-         {
-            on_tracking(*_tracking_element, tracking::end_tracking);
-            _tracking_time = now;
-            _tracking_element = nullptr;
-            _tracking_state = tracking::none;
-         }
+         on_tracking(*_tracking_element, tracking::end_tracking);
+         _tracking_time = now_;
+         _tracking_element = nullptr;
+         _tracking_state = tracking::none;
+      }
+      else
+      {
+         // Check again when the tracking times out
+         post(_tracking_time + 1s - now_, [this]() { check_tracking(); });
       }
    }
 
@@ -375,9 +755,17 @@
          _tracking_element && _tracking_element != &e)
          on_tracking(*_tracking_element, tracking::end_tracking);
 
+      bool was_tracking = _tracking_state != tracking::none;
       _tracking_element = &e;
       _tracking_state = state;
-      _tracking_time = std::chrono::steady_clock::now();
+      _tracking_time = now();
       on_tracking(e, state);
+
+      // End the tracking after it times out
+      if (!was_tracking)
+      {
+         using namespace std::chrono_literals;
+         post(1s, [this]() { check_tracking(); });
+      }
    }
 }}